@@ -23,6 +23,7 @@
 
 #ifndef GSPDF_PAGE_CACHE_H
 #include "gspdf-page-cache.h"
+#include "gspdf-page-layout.h"
 #endif
 
 /* Main Window's signal id*/
@@ -101,7 +102,6 @@ typedef struct {
 	gint            scale_mode;
 
 	gint            pointer_mode;
-	GspdfDocAction *link_action;
 
 	gdouble         hadj_val_prcnt;
 	gdouble         vadj_val_prcnt;
@@ -115,8 +115,15 @@ typedef struct {
 
 	gchar          *find_text;
 	gint            find_index;
+	// the hits on find_index, owned by the page cache
 	GList          *find_rect;
 	GList          *find_rect_iter;
+	// position of find_index among the page cache's find results
+	gint            find_result;
+	// hits found before find_rect
+	gint            find_match;
+	// the next result found is shown as soon as it arrives
+	gboolean        find_waiting;
 
 	GtkTreeStore   *outline;
 	GtkTreeIter     outline_iter;
@@ -125,9 +132,26 @@ typedef struct {
 	GtkTreeIter     bookmark_iter;
 
 	GPtrArray      *doc_map;
+	// offsets of the pages at the current scale, see get_page_layout
+	GspdfPageLayout *layout;
 
 	GspdfPageCache *page_cache;
 
+	// rendered pages waiting for the next frame to be redrawn
+	GArray         *render_pending;
+	guint           render_tick;
+
+	// what the drawing area shows, painted at the backing_x, backing_y
+	// scroll values rounded to whole pixels. Scrolling shifts it and only
+	// repaints the strips uncovered, anything else marks it dirty.
+	cairo_surface_t *backing;
+	cairo_surface_t *backing_spare;
+	cairo_region_t  *backing_dirty;
+	gint             backing_width;
+	gint             backing_height;
+	gdouble          backing_x;
+	gdouble          backing_y;
+
 	gint            signals[N_SIGNALS];
 } GspdfPageData;
 
@@ -165,9 +189,20 @@ get_current_page_data (GspdfApp *object);
 static gint
 get_n_pages (GspdfApp *object);
 
+static void
+update_active_page (GspdfApp  *object,
+                    GtkWidget *page);
+
 static void
 update_index_toolbar (GspdfApp *object);
 
+static void
+update_find_toolbar (GspdfApp      *object,
+                     GspdfPageData *page_data);
+
+static void
+update_find_count (GspdfPageData *page_data);
+
 static void
 update_config_bookmark (GspdfPageData *page_data);
 
@@ -198,6 +233,9 @@ get_page_allocated_width (GspdfPageData *page_data);
 static gdouble
 get_page_allocated_height (GspdfPageData *page_data);
 
+static GspdfPageLayout *
+get_page_layout (GspdfPageData *page_data);
+
 static gdouble
 get_page_maximum_width (GspdfPageData *page_data);
 
@@ -249,6 +287,20 @@ static void
 update_page_range_area (GspdfPageData        *page_data,
 					              const GspdfRectangle *area);
 
+static gboolean
+draw_tiled_page (GspdfPageData        *page_data,
+                 cairo_t              *cr,
+                 gint                  index,
+                 const GspdfRectangle *image_dim,
+                 const GspdfRectangle *surface_dim);
+
+static void
+draw_placeholder_page (GspdfPageData        *page_data,
+                       cairo_t              *cr,
+                       gint                  index,
+                       const GspdfRectangle *image_dim,
+                       const GspdfRectangle *surface_dim);
+
 static void
 draw_single_page (GspdfPageData        *page_data,
 				          GtkWidget            *widget,
@@ -270,6 +322,23 @@ update_page (GspdfPageData *page_data);
 static void
 scroll_page (GspdfPageData *page_data);
 
+static void
+invalidate_page (GspdfPageData *page_data);
+
+static void
+invalidate_page_index (GspdfPageData *page_data,
+                       gint           index);
+
+static void
+invalidate_selection (GspdfPageData *page_data);
+
+static void
+clear_backing (GspdfPageData *page_data);
+
+static void
+update_backing (GspdfPageData *page_data,
+                GtkWidget     *widget);
+
 static void
 update_hscroll_page_size (GspdfPageData *page_data,
                           gdouble        page);
@@ -380,6 +449,11 @@ on_notebook_page_switch (GtkNotebook *notebook,
 						             guint        page_num,
 						             gpointer     user_data);
 
+static void
+on_window_is_active_notify (GObject    *object,
+                            GParamSpec *pspec,
+                            gpointer    user_data);
+
 static void
 on_open_menu_item_activate (GtkMenuItem *menuitem,
                             gpointer     user_data);
@@ -532,8 +606,29 @@ on_page_cache_document_load_finished (GObject *object,
                                       gpointer user_data);
 
 static void
-on_page_cache_document_render_finished (GObject *object,
-                                        gpointer user_data);
+on_page_cache_document_render_finished (GObject  *object,
+                                        gpointer  pages,
+                                        gpointer  user_data);
+
+static void
+on_page_cache_document_map_changed (GObject  *object,
+                                    gint      start,
+                                    gint      end,
+                                    gpointer  user_data);
+
+static void
+on_page_cache_find_result (GObject  *object,
+                           gint      n,
+                           gpointer  user_data);
+
+static void
+on_page_cache_find_finished (GObject  *object,
+                             gpointer  user_data);
+
+static gboolean
+on_page_drawing_area_tick (GtkWidget     *widget,
+                           GdkFrameClock *frame_clock,
+                           gpointer       user_data);
 
 static gboolean
 on_outline_treeview_button_press (GtkWidget       *widget,
@@ -570,12 +665,6 @@ static void
 on_about_menu_item_activate (GtkMenuItem *menuitem,
 														 gpointer     user_data);
 
-static void
-on_g_list_rect_free_func (gpointer data)
-{
-	g_free ((GspdfRectangle*)data);
-}
-
 static void
 str_replace (gchar *str,
 			       gchar  target,
@@ -1059,6 +1148,13 @@ gspdf_app_init (GspdfApp *object)
 		NULL
 	);
 
+	g_signal_connect (
+		G_OBJECT (object),
+		"notify::is-active",
+		G_CALLBACK (on_window_is_active_notify),
+		NULL
+	);
+
 	gtk_window_set_default_size (GTK_WINDOW (object), 800, 600);
 	gtk_notebook_set_show_tabs (GTK_NOTEBOOK (notebook), FALSE);
 	gtk_notebook_append_page (GTK_NOTEBOOK (notebook), gspdf_page_new (), NULL);
@@ -1277,6 +1373,32 @@ get_n_pages (GspdfApp *object)
 	return gtk_notebook_get_n_pages (GTK_NOTEBOOK (notebook));
 }
 
+// only the shown tab of the focused window renders at full priority
+static void
+update_active_page (GspdfApp  *object,
+                    GtkWidget *page)
+{
+	GtkWidget *notebook = NULL;
+	g_object_get (G_OBJECT (object), "notebook", &notebook, NULL);
+	g_object_unref (notebook);
+
+	const gboolean focused = gtk_window_is_active (GTK_WINDOW (object));
+	GspdfPageData *page_data = NULL;
+	GtkWidget *child = NULL;
+
+	for (gint i = 0; i < get_n_pages (object); i++) {
+		child = gtk_notebook_get_nth_page (GTK_NOTEBOOK (notebook), i);
+		g_object_get (G_OBJECT (child), "user-data", &page_data, NULL);
+
+		if (page_data) {
+			gspdf_page_cache_set_active (
+				page_data->page_cache,
+				focused && (child == page)
+			);
+		}
+	}
+}
+
 static void
 update_index_toolbar (GspdfApp *object)
 {
@@ -1326,6 +1448,58 @@ update_index_toolbar (GspdfApp *object)
 	}
 }
 
+// "n of m", the hit shown among the hits found so far
+static void
+update_find_toolbar (GspdfApp      *object,
+                     GspdfPageData *page_data)
+{
+	GtkWidget *toolbar = NULL;
+	g_object_get (object, "toolbar", &toolbar, NULL);
+	g_object_unref (toolbar);
+
+	GtkWidget *find_label = NULL;
+	g_object_get (toolbar, "find-label-tool-item", &find_label, NULL);
+	g_object_unref (find_label);
+
+	if (page_data->document && page_data->find_text) {
+		gint n = 0;
+
+		if (page_data->find_rect_iter) {
+			n = page_data->find_match + 1 +
+				g_list_position (page_data->find_rect, page_data->find_rect_iter);
+		}
+
+		gchar *temp = g_strdup_printf (
+			" %d of %d",
+			n,
+			gspdf_page_cache_get_n_find_matches (page_data->page_cache)
+		);
+
+		gtk_label_set_text (
+			GTK_LABEL (gtk_bin_get_child (GTK_BIN (find_label))),
+			temp
+		);
+		g_free (temp);
+	} else {
+		gtk_label_set_text (
+			GTK_LABEL (gtk_bin_get_child (GTK_BIN (find_label))),
+			""
+		);
+	}
+}
+
+// results keep coming for tabs in the background, the toolbar only
+// follows the one in front
+static void
+update_find_count (GspdfPageData *page_data)
+{
+	GspdfApp *app = GSPDF_APP (page_data->window);
+
+	if (page_data == get_current_page_data (app)) {
+		update_find_toolbar (app, page_data);
+	}
+}
+
 static gboolean
 _bookmark_iter_foreach_func (GtkTreeModel *model,
                              GtkTreePath *path,
@@ -1481,16 +1655,26 @@ close_document (GspdfPageData *page_data)
 	update_config_cache (page_data);
 	save_config (GSPDF_APP (page_data->window));
 
+	// the hits belong to the page cache's search of this document
+	clear_find (page_data);
+
 	if (page_data->document) {
 		g_object_unref (page_data->document);
 		page_data->document = NULL;
 	}
 
+	if (page_data->layout) {
+		gspdf_page_layout_free (page_data->layout);
+		page_data->layout = NULL;
+	}
+
 	if (page_data->doc_map) {
 		g_ptr_array_unref (page_data->doc_map);
 		page_data->doc_map = NULL;
 	}
 
+	clear_backing (page_data);
+
 	page_data->index = 0;
 	page_data->continuous = DEFAULT_CONTINUOUS_VALUE;
 	page_data->hadj_val_prcnt = 0;
@@ -1623,40 +1807,71 @@ get_page_allocated_height (GspdfPageData *page_data)
 	return gtk_widget_get_allocated_height (drawing_area);
 }
 
-static gdouble
-get_page_maximum_width (GspdfPageData *page_data)
+// rebuilt whenever the document map, the scale or the spacing change
+static GspdfPageLayout *
+get_page_layout (GspdfPageData *page_data)
 {
 	if (page_data->doc_map == NULL) {
-		return -1;
+		return NULL;
 	}
 
-	gdouble ret = 0;
+	if (page_data->layout &&
+	    !gspdf_page_layout_is_valid (
+	      page_data->layout,
+	      page_data->doc_map,
+	      page_data->scale,
+	      page_data->spacing))
+	{
+		gspdf_page_layout_free (page_data->layout);
+		page_data->layout = NULL;
+	}
 
-	for (gint i = 0; i < page_data->doc_map->len; i++) {
-		if ((((GspdfDocMap*)g_ptr_array_index (page_data->doc_map, i))->width) > ret) {
-			ret = ((GspdfDocMap*)g_ptr_array_index (page_data->doc_map, i))->width;
-		}
+	if (!page_data->layout) {
+		page_data->layout = gspdf_page_layout_new (
+			page_data->doc_map,
+			page_data->scale,
+			page_data->spacing
+		);
 	}
 
-	return ret;
+	return page_data->layout;
+}
+
+// like gspdf_page_layout_get_page_at but a y on the bottom edge of a slot
+// still belongs to it
+static gint
+_get_page_at_or_above (GspdfPageLayout *layout,
+                       gdouble          y)
+{
+	const gint n_pages = gspdf_page_layout_get_n_pages (layout);
+	const gint index = gspdf_page_layout_get_page_at (layout, y);
+	const gint prev = (index < 0) ? n_pages - 1 : index - 1;
+
+	if ((prev >= 0) && (y == gspdf_page_layout_get_offset (layout, prev + 1))) {
+		return prev;
+	}
+
+	return index;
 }
 
 static gdouble
-get_page_maximum_height (GspdfPageData *page_data)
+get_page_maximum_width (GspdfPageData *page_data)
 {
 	if (page_data->doc_map == NULL) {
 		return -1;
 	}
 
-	gdouble ret = 0;
+	return gspdf_page_layout_get_max_width (get_page_layout (page_data));
+}
 
-	for (gint i = 0; i < page_data->doc_map->len; i++) {
-		if ((((GspdfDocMap*)g_ptr_array_index (page_data->doc_map, i))->height) > ret) {
-			ret = ((GspdfDocMap*)g_ptr_array_index (page_data->doc_map, i))->height;
-		}
+static gdouble
+get_page_maximum_height (GspdfPageData *page_data)
+{
+	if (page_data->doc_map == NULL) {
+		return -1;
 	}
 
-	return ret;
+	return gspdf_page_layout_get_max_height (get_page_layout (page_data));
 }
 
 static gdouble
@@ -1666,15 +1881,7 @@ get_page_total_height (GspdfPageData *page_data)
 		return -1;
 	}
 
-	gdouble ret = 0;
-
-	for (gint i = 0; i < page_data->doc_map->len; i++) {
-		ret +=
-			((((GspdfDocMap*)g_ptr_array_index (page_data->doc_map, i))->height) * page_data->scale);
-		ret += page_data->spacing;
-	}
-
-	return ret;
+	return gspdf_page_layout_get_total_height (get_page_layout (page_data));
 }
 
 static gdouble
@@ -1685,16 +1892,7 @@ get_page_y_offset (GspdfPageData *page_data,
 		return -1;
 	}
 
-	gdouble ret = 0;
-
-	for (gint i = 1; i <= index; i++) {
-		ret +=
-			((((GspdfDocMap*)g_ptr_array_index (page_data->doc_map, i-1))->height) * page_data->scale);
-
-		ret += page_data->spacing;
-	}
-
-	return ret;
+	return gspdf_page_layout_get_offset (get_page_layout (page_data), index);
 }
 
 static gboolean
@@ -1722,42 +1920,40 @@ get_current_pointer_position (GspdfPageData *page_data,
 
 	if (page_data->continuous) {
 		const gdouble max_width = get_page_maximum_width (page_data) * page_data->scale;
-		GspdfDocMap *doc_map = NULL;
-		gdouble page_width = 0, page_height = 0;
-		gdouble pos = 0;
+		const gint i = gspdf_page_layout_get_page_at (
+			get_page_layout (page_data),
+			y_scroll + y_win
+		);
 
-		for (gint i = 0; i < page_data->doc_map->len; i++) {
-			doc_map = (GspdfDocMap*) g_ptr_array_index (page_data->doc_map, i);
-			page_width = doc_map->width * page_data->scale;
-			page_height =  (doc_map->height * page_data->scale) + page_data->spacing;
-			pos += page_height;
-
-			if ((y_scroll + y_win) < pos) {
-				const gdouble offset_y = y_scroll - get_page_y_offset (page_data, i);
-				in = i;
-				if (max_width > width) {
-					if (page_width < max_width) {
-						const gdouble abs_width = ((max_width - page_width)/2) - x_scroll;
-						if (page_width > width) {
+		if (i >= 0) {
+			const GspdfDocMap *doc_map = (GspdfDocMap*) g_ptr_array_index (
+				page_data->doc_map,
+				i
+			);
+			const gdouble page_width = doc_map->width * page_data->scale;
+			const gdouble offset_y = y_scroll - get_page_y_offset (page_data, i);
+			in = i;
+			if (max_width > width) {
+				if (page_width < max_width) {
+					const gdouble abs_width = ((max_width - page_width)/2) - x_scroll;
+					if (page_width > width) {
+						x =  x_win - abs_width;
+					} else {
+						if ((x_win > abs_width) && (x_win < (abs_width + page_width))) {
 							x =  x_win - abs_width;
-						} else {
-							if ((x_win > abs_width) && (x_win < (abs_width + page_width))) {
-								x =  x_win - abs_width;
-							}
 						}
-					} else {
-						x = x_scroll + x_win;
 					}
 				} else {
-					const gdouble abs_width = (width - page_width)/2;
-					if ((x_win > abs_width) && (x_win < (abs_width + page_width))) {
-						x = x_win - abs_width;
-					}
+					x = x_scroll + x_win;
+				}
+			} else {
+				const gdouble abs_width = (width - page_width)/2;
+				if ((x_win > abs_width) && (x_win < (abs_width + page_width))) {
+					x = x_win - abs_width;
 				}
-				y = offset_y + y_win;
-				ret = TRUE;
-				break;
 			}
+			y = offset_y + y_win;
+			ret = TRUE;
 		}
 	} else {
 		const GspdfDocMap *doc_map = (GspdfDocMap*) g_ptr_array_index (
@@ -1806,30 +2002,16 @@ get_index_page_area (GspdfPageData        *page_data,
 		return FALSE;
 	}
 
-	gint s = -1, e = -1;
-	gdouble pos = 0;
-	gboolean ret = FALSE;
-
-	for (gint i = 0; i < page_data->doc_map->len; i++) {
-
-		pos +=
-			((((GspdfDocMap*)g_ptr_array_index (page_data->doc_map, i))->height) * page_data->scale);
-
-		pos += page_data->spacing;
-
-		if (area->y <= pos) {
-
-			if (s < 0) { s = i; }
+	GspdfPageLayout *layout = get_page_layout (page_data);
+	gint s = _get_page_at_or_above (layout, area->y);
+	gint e = -1;
+	gboolean ret = (s >= 0);
 
-			if (!ret) { ret = TRUE; }
+	if (ret) {
+		e = _get_page_at_or_above (layout, area->y + area->height);
 
-			if ((area->y + area->height) <= pos) {
-
-				if (e < 0) { e = i; }
-
-				break;
-
-			}
+		if ((e >= 0) && (e < s)) {
+			e = s;
 		}
 	}
 
@@ -1872,95 +2054,89 @@ get_selected_area (GspdfPageData        *page_data,
 		const gdouble max_width = floor
 			(get_page_maximum_width (page_data) * page_data->scale);
 
+		GspdfPageLayout *layout = get_page_layout (page_data);
 		GspdfDocMap *doc_map = NULL;
-		gdouble page_width = 0, page_height = 0;
-		gdouble pos = 0;
-
-		for (gint i = 0; i < page_data->doc_map->len; i++) {
-
-			doc_map = (GspdfDocMap*)g_ptr_array_index (page_data->doc_map, i);
-			page_width = doc_map->width * page_data->scale;
-			page_height =  (doc_map->height * page_data->scale) + page_data->spacing;
+		gdouble page_width = 0;
 
-			pos += page_height;
+		s = gspdf_page_layout_get_page_at (layout, y_scroll + selection->y);
 
-			if ((y_scroll + selection->y) < pos) {
+		if (s >= 0) {
 
-				// start index
-
-				if (s < 0) {
-
-					s = i;
-
-					// compute x
+			doc_map = (GspdfDocMap*)g_ptr_array_index (page_data->doc_map, s);
+			page_width = doc_map->width * page_data->scale;
 
-					if (max_width > width) {
+			// compute x
 
-						const gdouble abs_width = ((max_width - page_width)/2) - x_scroll;
+			if (max_width > width) {
 
-						if (page_width < max_width) {
+				const gdouble abs_width = ((max_width - page_width)/2) - x_scroll;
 
-							if (page_width > width) {
+				if (page_width < max_width) {
 
-								x =  selection->x - abs_width;
+					if (page_width > width) {
 
-							} else {
+						x =  selection->x - abs_width;
 
-								x = (selection->x >= abs_width) ?
-									selection->x - abs_width : 0;
-							}
+					} else {
 
-						} else {
+						x = (selection->x >= abs_width) ?
+							selection->x - abs_width : 0;
+					}
 
-							x = x_scroll + selection->x;
+				} else {
 
-						}
+					x = x_scroll + selection->x;
 
-					} else {
+				}
 
-						const gdouble abs_width = (width - page_width)/2;
+			} else {
 
-						x = (selection->x >= abs_width) ?
-							(selection->x - abs_width) + x_scroll : x_scroll;
+				const gdouble abs_width = (width - page_width)/2;
 
-					}
+				x = (selection->x >= abs_width) ?
+					(selection->x - abs_width) + x_scroll : x_scroll;
 
-					// compute y
+			}
 
-					y = ((y_scroll - get_page_y_offset (page_data, i)) + selection->y);
+			// compute y
 
-				}
+			y = ((y_scroll - get_page_y_offset (page_data, s)) + selection->y);
 
-				if ((y_scroll + selection->y + selection->height) < pos) {
+			// end index, a selection dragged upwards ends on its first page
 
-					if (e < 0) {
+			e = gspdf_page_layout_get_page_at (
+				layout,
+				y_scroll + selection->y + selection->height
+			);
 
-						e = i;
+			if ((e >= 0) && (e < s)) {
+				e = s;
+			}
 
-						// compute w
+		}
 
-						if (selection->width < page_width) {
+		if (e >= 0) {
 
-							w = selection->width;
+			doc_map = (GspdfDocMap*)g_ptr_array_index (page_data->doc_map, e);
+			page_width = doc_map->width * page_data->scale;
 
-						} else {
+			// compute w
 
-							w = page_width;
+			if (selection->width < page_width) {
 
-						}
+				w = selection->width;
 
-						// compute h
+			} else {
 
-						h = selection->height;
+				w = page_width;
 
-					}
+			}
 
-					ret = TRUE;
-					break;
+			// compute h
 
-				}
+			h = selection->height;
 
-			}
+			ret = TRUE;
 
 		}
 
@@ -2163,6 +2339,8 @@ update_page_range (GspdfPageData *page_data,
 				           gint           start,
 				           gint           end)
 {
+	// single page mode only prefetches the neighbours
+	gspdf_page_cache_set_continuous (page_data->page_cache, page_data->continuous);
 	gspdf_page_cache_set_range (page_data->page_cache, start, end, page_data->scale);
 }
 
@@ -2186,6 +2364,104 @@ update_page_range_area (GspdfPageData        *page_data,
 	update_page_range (page_data, start, end);
 }
 
+// composite the tiles covering the visible part of a large page,
+// returns FALSE while none of them is rendered yet
+static gboolean
+draw_tiled_page (GspdfPageData        *page_data,
+                 cairo_t              *cr,
+                 gint                  index,
+                 const GspdfRectangle *image_dim,
+                 const GspdfRectangle *surface_dim)
+{
+	GList *tiles = gspdf_page_cache_get_tiles (
+		page_data->page_cache,
+		index,
+		image_dim
+	);
+
+	if (!tiles) {
+		return FALSE;
+	}
+
+	cairo_save (cr);
+
+	cairo_rectangle (
+		cr,
+		surface_dim->x,
+		surface_dim->y,
+		image_dim->width,
+		image_dim->height
+	);
+	cairo_clip (cr);
+
+	GList *iter = tiles;
+	GspdfPageCacheTile *tile = NULL;
+
+	while (iter) {
+		tile = (GspdfPageCacheTile*) iter->data;
+
+		cairo_set_source_surface (
+			cr,
+			tile->surface,
+			(tile->rect.x - image_dim->x) + surface_dim->x,
+			(tile->rect.y - image_dim->y) + surface_dim->y
+		);
+		cairo_paint (cr);
+
+		iter = iter->next;
+	}
+
+	cairo_restore (cr);
+
+	g_list_free_full (tiles, (GDestroyNotify) gspdf_page_cache_tile_free);
+
+	return TRUE;
+}
+
+// stretch a render made at another scale while the current one is pending
+static void
+draw_placeholder_page (GspdfPageData        *page_data,
+                       cairo_t              *cr,
+                       gint                  index,
+                       const GspdfRectangle *image_dim,
+                       const GspdfRectangle *surface_dim)
+{
+	gdouble scale = 0;
+	cairo_surface_t *image_surface = gspdf_page_cache_get_placeholder (
+		page_data->page_cache,
+		index,
+		&scale
+	);
+
+	if (!image_surface) {
+		return;
+	}
+
+	cairo_save (cr);
+
+	cairo_rectangle (
+		cr,
+		surface_dim->x,
+		surface_dim->y,
+		image_dim->width,
+		image_dim->height
+	);
+	cairo_clip (cr);
+
+	cairo_translate (
+		cr,
+		surface_dim->x - image_dim->x,
+		surface_dim->y - image_dim->y
+	);
+	cairo_scale (cr, page_data->scale / scale, page_data->scale / scale);
+	cairo_set_source_surface (cr, image_surface, 0, 0);
+	cairo_paint (cr);
+
+	cairo_restore (cr);
+
+	cairo_surface_destroy (image_surface);
+}
+
 static void
 draw_single_page (GspdfPageData        *page_data,
 				  GtkWidget            *widget,
@@ -2213,76 +2489,109 @@ draw_single_page (GspdfPageData        *page_data,
 
 	// draw a page
 
-	GdkPixbuf *pixbuf = gspdf_page_cache_get_pixbuf (page_data->page_cache, index);
-
-	if (pixbuf) {
-
-		cairo_surface_t *image_surface = cairo_image_surface_create_for_data (
-			gdk_pixbuf_get_pixels (pixbuf),
-			CAIRO_FORMAT_ARGB32,
-			gdk_pixbuf_get_width (pixbuf),
-			gdk_pixbuf_get_height (pixbuf),
-			gdk_pixbuf_get_width (pixbuf) * 4
-		);
+	gboolean drawn = FALSE;
 
-		cairo_surface_t *surface = cairo_surface_create_for_rectangle (
-			image_surface,
-			image_dim->x,
-			image_dim->y,
-			image_dim->width,
-			image_dim->height
+	if (gspdf_page_cache_is_tiled (page_data->page_cache, index)) {
+		drawn = draw_tiled_page (page_data, cr, index, image_dim, surface_dim);
+	} else {
+		cairo_surface_t *image_surface = gspdf_page_cache_get_surface (
+			page_data->page_cache,
+			index
 		);
 
-		cairo_set_source_surface (cr, surface, surface_dim->x, surface_dim->y);
-
-		cairo_paint (cr);
-
-		// draw selection
-		GList *iter = selection;
-		GspdfRectangle *rect = NULL;
-
-		while (iter) {
-			rect = (GspdfRectangle*) iter->data;
+		if (image_surface) {
+			cairo_save (cr);
 
-			cairo_set_source_rgba (cr, 0.4, 0.698, 1.0, 0.5);
 			cairo_rectangle (
 				cr,
-				((rect->x * page_data->scale) - image_dim->x) + surface_dim->x,
-				((rect->y * page_data->scale) - image_dim->y) + surface_dim->y,
-				rect->width * page_data->scale,
-				rect->height * page_data->scale
+				surface_dim->x,
+				surface_dim->y,
+				image_dim->width,
+				image_dim->height
 			);
-			cairo_fill (cr);
-
-			iter = iter->next;
-		}
+			cairo_clip (cr);
 
-		// draw a find label
-		if (find_label) {
-			cairo_set_source_rgba (cr, 1.0, 1.0, 0.0, 0.5);
-			cairo_rectangle (
+			cairo_set_source_surface (
 				cr,
-				((find_label->x * page_data->scale) - image_dim->x) + surface_dim->x,
-				((find_label->y * page_data->scale) - image_dim->y) + surface_dim->y,
-				find_label->width * page_data->scale,
-				find_label->height * page_data->scale
+				image_surface,
+				surface_dim->x - image_dim->x,
+				surface_dim->y - image_dim->y
 			);
-			cairo_fill (cr);
-
-		}
+			cairo_paint (cr);
 
-		cairo_surface_destroy (surface);
+			cairo_restore (cr);
 
-		cairo_surface_destroy (image_surface);
+			cairo_surface_destroy (image_surface);
 
-		g_object_unref (pixbuf);
+			drawn = TRUE;
+		}
+	}
 
+	if (!drawn) {
+		draw_placeholder_page (page_data, cr, index, image_dim, surface_dim);
+		return;
 	}
-}
 
-static void
-draw_page (GspdfPageData *page_data,
-		   GtkWidget     *widget,
+	// draw selection
+	GList *iter = selection;
+	GspdfRectangle *rect = NULL;
+
+	while (iter) {
+		rect = (GspdfRectangle*) iter->data;
+
+		cairo_set_source_rgba (cr, 0.4, 0.698, 1.0, 0.5);
+		cairo_rectangle (
+			cr,
+			((rect->x * page_data->scale) - image_dim->x) + surface_dim->x,
+			((rect->y * page_data->scale) - image_dim->y) + surface_dim->y,
+			rect->width * page_data->scale,
+			rect->height * page_data->scale
+		);
+		cairo_fill (cr);
+
+		iter = iter->next;
+	}
+
+	// draw a find label
+	if (find_label) {
+		cairo_set_source_rgba (cr, 1.0, 1.0, 0.0, 0.5);
+		cairo_rectangle (
+			cr,
+			((find_label->x * page_data->scale) - image_dim->x) + surface_dim->x,
+			((find_label->y * page_data->scale) - image_dim->y) + surface_dim->y,
+			find_label->width * page_data->scale,
+			find_label->height * page_data->scale
+		);
+		cairo_fill (cr);
+	}
+}
+
+// the height draw_page gives page index in continuous mode, whole pixels
+static gint
+get_page_draw_height (GspdfPageData *page_data,
+                      gint           index)
+{
+	const GspdfDocMap *doc_map = (GspdfDocMap*) g_ptr_array_index (
+		page_data->doc_map,
+		index
+	);
+
+	return floor (doc_map->height) * page_data->scale;
+}
+
+// how much of page start, the first of the range, draw_page leaves above
+// the drawing area in continuous mode
+static gint
+get_page_draw_offset (GspdfPageData *page_data,
+                      gint           start,
+                      gdouble        scroll_y)
+{
+	return scroll_y - get_page_y_offset (page_data, start);
+}
+
+static void
+draw_page (GspdfPageData *page_data,
+		   GtkWidget     *widget,
            cairo_t       *cr)
 {
 	GtkWidget *hscroll = NULL;
@@ -2314,14 +2623,18 @@ draw_page (GspdfPageData *page_data,
 		gspdf_page_cache_get_range (page_data->page_cache, &start, &end);
 
 		const gdouble max_width = floor (get_page_maximum_width (page_data) * page_data->scale);
-		const gint offset = scroll_y - get_page_y_offset (page_data, start);
+		const gint offset = get_page_draw_offset (page_data, start, scroll_y);
+
+		// pages outside the part being repainted are skipped
+		gdouble clip_x1 = 0, clip_y1 = 0, clip_x2 = 0, clip_y2 = 0;
+		cairo_clip_extents (cr, &clip_x1, &clip_y1, &clip_x2, &clip_y2);
 
 		for (gint i = start; i <= end; i++) {
 
 			doc_map = (GspdfDocMap*) g_ptr_array_index (page_data->doc_map, i);
 
 			page_width = floor (doc_map->width) * page_data->scale;
-			page_height = floor (doc_map->height) * page_data->scale;
+			page_height = get_page_draw_height (page_data, i);
 
 			if (max_width > alloc_width) {
 
@@ -2380,7 +2693,10 @@ draw_page (GspdfPageData *page_data,
 				iter = iter->next;
 			}
 
-			if (image_dim.height > 0) {
+			if ((image_dim.height > 0) &&
+			    (surface_dim.y < clip_y2) &&
+			    ((surface_dim.y + image_dim.height) > clip_y1))
+			{
 				draw_single_page (
 					page_data,
 					widget,
@@ -2460,6 +2776,261 @@ draw_page (GspdfPageData *page_data,
 	}
 }
 
+static void
+invalidate_page (GspdfPageData *page_data)
+{
+	if (page_data->backing_dirty) {
+		const cairo_rectangle_int_t rect = {
+			0,
+			0,
+			page_data->backing_width,
+			page_data->backing_height
+		};
+
+		cairo_region_union_rectangle (page_data->backing_dirty, &rect);
+	}
+
+	gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
+}
+
+// the part of the drawing area page index covers, laid out as in draw_page
+static gboolean
+get_page_screen_rect (GspdfPageData         *page_data,
+                      gint                   index,
+                      cairo_rectangle_int_t *rect)
+{
+	const gint width = (gint) get_page_allocated_width (page_data);
+	const gint height = (gint) get_page_allocated_height (page_data);
+
+	if (!page_data->doc_map) {
+		return FALSE;
+	}
+
+	if (!page_data->continuous) {
+		if (index != page_data->index) {
+			return FALSE;
+		}
+
+		rect->x = 0;
+		rect->y = 0;
+		rect->width = width;
+		rect->height = height;
+
+		return TRUE;
+	}
+
+	gint start = 0, end = 0;
+	gspdf_page_cache_get_range (page_data->page_cache, &start, &end);
+
+	if ((index < start) || (index > end)) {
+		return FALSE;
+	}
+
+	// the first page starts above the drawing area, the others follow
+	// it as draw_page steps through them
+	gdouble pos_y = -get_page_draw_offset (
+		page_data,
+		start,
+		get_vscroll_value (page_data)
+	);
+
+	for (gint i = start; i < index; i++) {
+		pos_y += get_page_draw_height (page_data, i) + page_data->spacing;
+	}
+
+	// a pixel of slack for the backing store's rounded origin
+	const gint top = MAX ((gint) floor (pos_y) - 1, 0);
+	const gint bottom = MIN (
+		(gint) ceil (pos_y + get_page_draw_height (page_data, index)) + 1,
+		height
+	);
+
+	if (bottom <= top) {
+		return FALSE;
+	}
+
+	rect->x = 0;
+	rect->y = top;
+	rect->width = width;
+	rect->height = bottom - top;
+
+	return TRUE;
+}
+
+// repaints only the part of the drawing area showing page index
+static void
+invalidate_page_index (GspdfPageData *page_data,
+                       gint           index)
+{
+	cairo_rectangle_int_t rect;
+
+	if (!get_page_screen_rect (page_data, index, &rect)) {
+		return;
+	}
+
+	// the dirty region is in the coordinates of the backing store, which
+	// may lag behind a pending scroll
+	if (page_data->backing_dirty) {
+		const cairo_rectangle_int_t backing_rect = {
+			rect.x + (gint) (get_hscroll_value (page_data) - page_data->backing_x),
+			rect.y + (gint) (get_vscroll_value (page_data) - page_data->backing_y),
+			rect.width,
+			rect.height
+		};
+
+		cairo_region_union_rectangle (page_data->backing_dirty, &backing_rect);
+	}
+
+	GtkWidget *drawing_area = NULL;
+	g_object_get (G_OBJECT (page_data->page), "drawing-area", &drawing_area, NULL);
+
+	gtk_widget_queue_draw_area (
+		drawing_area,
+		rect.x,
+		rect.y,
+		rect.width,
+		rect.height
+	);
+
+	g_object_unref (drawing_area);
+}
+
+static void
+invalidate_selection (GspdfPageData *page_data)
+{
+	GList *iter = page_data->selection;
+
+	while (iter) {
+		invalidate_page_index (
+			page_data,
+			((GspdfPageSelection*) iter->data)->index
+		);
+		iter = iter->next;
+	}
+}
+
+static void
+clear_backing (GspdfPageData *page_data)
+{
+	if (page_data->backing) {
+		cairo_surface_destroy (page_data->backing);
+		cairo_surface_destroy (page_data->backing_spare);
+		cairo_region_destroy (page_data->backing_dirty);
+		page_data->backing = NULL;
+		page_data->backing_spare = NULL;
+		page_data->backing_dirty = NULL;
+	}
+}
+
+// brings the backing store up to date with the scroll position and
+// repaints its dirty parts
+static void
+update_backing (GspdfPageData *page_data,
+                GtkWidget     *widget)
+{
+	const gint width = gtk_widget_get_allocated_width (widget);
+	const gint height = gtk_widget_get_allocated_height (widget);
+	// the store is kept at whole pixel origins so that any scroll can be
+	// blitted, the fraction left over is made up when painting
+	const gdouble scroll_x = round (get_hscroll_value (page_data));
+	const gdouble scroll_y = round (get_vscroll_value (page_data));
+	const cairo_rectangle_int_t full = { 0, 0, width, height };
+
+	if (page_data->backing &&
+	    ((page_data->backing_width != width) ||
+	     (page_data->backing_height != height)))
+	{
+		clear_backing (page_data);
+	}
+
+	if (!page_data->backing) {
+		page_data->backing = gdk_window_create_similar_surface (
+			gtk_widget_get_window (widget),
+			CAIRO_CONTENT_COLOR,
+			width,
+			height
+		);
+		page_data->backing_spare = gdk_window_create_similar_surface (
+			gtk_widget_get_window (widget),
+			CAIRO_CONTENT_COLOR,
+			width,
+			height
+		);
+		page_data->backing_dirty = cairo_region_create_rectangle (&full);
+		page_data->backing_width = width;
+		page_data->backing_height = height;
+	} else {
+		const gint dx = (gint) (scroll_x - page_data->backing_x);
+		const gint dy = (gint) (scroll_y - page_data->backing_y);
+
+		if (((dx != 0) || (dy != 0)) &&
+		    (ABS (dx) < width) && (ABS (dy) < height))
+		{
+			// a surface can't be painted onto itself, shift into the spare
+			cairo_t *spare_cr = cairo_create (page_data->backing_spare);
+			cairo_set_operator (spare_cr, CAIRO_OPERATOR_SOURCE);
+			cairo_set_source_surface (spare_cr, page_data->backing, -dx, -dy);
+			cairo_paint (spare_cr);
+			cairo_destroy (spare_cr);
+
+			cairo_surface_t *tmp = page_data->backing;
+			page_data->backing = page_data->backing_spare;
+			page_data->backing_spare = tmp;
+
+			const cairo_rectangle_int_t kept = { -dx, -dy, width, height };
+			cairo_region_t *exposed = cairo_region_create_rectangle (&full);
+			cairo_region_subtract_rectangle (exposed, &kept);
+
+			cairo_region_translate (page_data->backing_dirty, -dx, -dy);
+			cairo_region_union (page_data->backing_dirty, exposed);
+			cairo_region_intersect_rectangle (page_data->backing_dirty, &full);
+			cairo_region_destroy (exposed);
+		} else if ((dx != 0) || (dy != 0)) {
+			cairo_region_union_rectangle (page_data->backing_dirty, &full);
+		}
+	}
+
+	page_data->backing_x = scroll_x;
+	page_data->backing_y = scroll_y;
+
+	if (cairo_region_is_empty (page_data->backing_dirty)) {
+		return;
+	}
+
+	cairo_t *cr = cairo_create (page_data->backing);
+
+	gdk_cairo_region (cr, page_data->backing_dirty);
+	cairo_clip (cr);
+
+	// the drawing area is transparent, start from the window's background
+	gtk_render_background (
+		gtk_widget_get_style_context (gtk_widget_get_toplevel (widget)),
+		cr,
+		0,
+		0,
+		width,
+		height
+	);
+
+	cairo_set_source_rgba (cr, 0, 0, 0, 0.4);
+	cairo_rectangle (cr, 0, 0, width, height);
+	cairo_fill (cr);
+
+	// draw_page lays pages out at the exact scroll values
+	cairo_translate (
+		cr,
+		get_hscroll_value (page_data) - scroll_x,
+		get_vscroll_value (page_data) - scroll_y
+	);
+
+	draw_page (page_data, widget, cr);
+
+	cairo_destroy (cr);
+
+	cairo_region_destroy (page_data->backing_dirty);
+	page_data->backing_dirty = cairo_region_create ();
+}
+
 static void
 update_page (GspdfPageData *page_data)
 {
@@ -2472,7 +3043,6 @@ update_page (GspdfPageData *page_data)
 
 	update_hscroll_page_size (page_data, width);
 	update_vscroll_page_size (page_data, height);
-	gspdf_page_cache_clear (page_data->page_cache);
 
 	switch (page_data->scale_mode) {
 		case SCALE_NORMAL:
@@ -2522,15 +3092,10 @@ update_page (GspdfPageData *page_data)
 	} else {
 		update_hscroll_value_block (page_data, 0);
 		update_vscroll_value_block (page_data, 0);
-		gspdf_page_cache_set_range (
-			page_data->page_cache,
-			page_data->index,
-			page_data->index,
-			page_data->scale
-		);
+		update_page_range (page_data, page_data->index, page_data->index);
 	}
 
-	gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
+	invalidate_page (page_data);
 }
 
 static void
@@ -2560,6 +3125,8 @@ scroll_page (GspdfPageData *page_data)
 	}
 
 	update_index_toolbar (GSPDF_APP (page_data->window));
+
+	// the backing store catches up with the scroll on the next draw
 	gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
 }
 
@@ -2922,89 +3489,118 @@ process_action (GspdfPageData *page_data, GspdfDocAction *action)
 }
 
 static void
-find_text (GspdfPageData *page_data, const gchar *text, GspdfFindFlags options)
+show_find_result (GspdfPageData *page_data,
+                  gint           n)
 {
-	GspdfDocumentPage *doc_page = NULL;
-	GList *res = NULL;
-	gint index = page_data->index;
+	gint index = -1, match = 0;
+	GList *rects = gspdf_page_cache_get_find_result (
+		page_data->page_cache,
+		n,
+		&index,
+		&match
+	);
 
-	if (g_strcmp0 (page_data->find_text, text) == 0) {
-		page_data->find_rect_iter = page_data->find_rect_iter->next;
+	if (!rects) {
+		return;
+	}
 
-		if ((page_data->find_rect_iter) && (page_data->index == page_data->find_index)) {
+	const gint prev_index = page_data->find_index;
 
-			if (!page_data->continuous) {
-				gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
-			}
+	page_data->find_result = n;
+	page_data->find_match = match;
+	page_data->find_index = index;
+	page_data->find_rect = rects;
+	page_data->find_rect_iter = rects;
 
-			goto_page_at_pos (
-				page_data,
-				page_data->index,
-				((GspdfRectangle*)page_data->find_rect_iter->data)->x,
-				((GspdfRectangle*)page_data->find_rect_iter->data)->y * page_data->scale
-			);
+	update_find_count (page_data);
 
-			return;
+	if (page_data->continuous) {
+		// the highlight moves off prev_index and onto index
+		if (prev_index != index) {
+			invalidate_page_index (page_data, prev_index);
 		}
 
-		index += 1;
-	}
-
-	if (page_data->find_text) {
-		g_free (page_data->find_text);
-		page_data->find_text = NULL;
-	}
-
-	if (index >= gspdf_document_get_n_pages (page_data->document)) {
-		index = 0;
+		invalidate_page_index (page_data, index);
+	} else {
+		invalidate_page (page_data);
 	}
 
-	if (page_data->find_rect) {
-		g_list_free_full (page_data->find_rect, on_g_list_rect_free_func);
-		page_data->find_rect = NULL;
-	}
+	goto_page_at_pos (
+		page_data,
+		page_data->find_index,
+		((GspdfRectangle*)page_data->find_rect_iter->data)->x,
+		((GspdfRectangle*)page_data->find_rect_iter->data)->y * page_data->scale
+	);
+}
 
-	for (gint i = index; i < gspdf_document_get_n_pages (page_data->document); i++) {
-		doc_page = gspdf_document_get_page (page_data->document, i);
-		res = gspdf_document_page_find_text (doc_page, text, options);
+// the search runs on the workers, its results are shown as they come
+static void
+find_text (GspdfPageData *page_data, const gchar *text, GspdfFindFlags options)
+{
+	if (g_strcmp0 (page_data->find_text, text) == 0) {
+		// the next hit on the same page
+		if (page_data->find_rect_iter && page_data->find_rect_iter->next) {
+			page_data->find_rect_iter = page_data->find_rect_iter->next;
+			update_find_count (page_data);
 
-		g_object_unref (doc_page);
+			if (page_data->continuous) {
+				invalidate_page_index (page_data, page_data->find_index);
+			} else {
+				invalidate_page (page_data);
+			}
 
-		if (res) {
-			page_data->find_text = g_strdup (text);
-			page_data->find_index = i;
-			page_data->find_rect = res;
-			page_data->find_rect_iter = res;
 			goto_page_at_pos (
 				page_data,
 				page_data->find_index,
 				((GspdfRectangle*)page_data->find_rect_iter->data)->x,
 				((GspdfRectangle*)page_data->find_rect_iter->data)->y * page_data->scale
 			);
+
 			return;
 		}
+
+		// the next page with hits, which may not be found yet
+		const gint n = gspdf_page_cache_get_n_find_results (page_data->page_cache);
+
+		if ((page_data->find_result + 1) < n) {
+			show_find_result (page_data, page_data->find_result + 1);
+		} else if (gspdf_page_cache_is_finding (page_data->page_cache)) {
+			page_data->find_waiting = TRUE;
+		} else if (n > 0) {
+			show_find_result (page_data, 0);
+		}
+
+		return;
 	}
+
+	clear_find (page_data);
+
+	page_data->find_text = g_strdup (text);
+	page_data->find_waiting = TRUE;
+
+	gspdf_page_cache_find (page_data->page_cache, text, options, page_data->index);
+	update_find_count (page_data);
 }
 
 static void
 clear_find (GspdfPageData *page_data)
 {
+	gspdf_page_cache_find_cancel (page_data->page_cache);
+
 	if (page_data->find_text) {
 		g_free (page_data->find_text);
 		page_data->find_text = NULL;
 	}
 
-	if (page_data->find_rect) {
-		g_list_free_full (
-			page_data->find_rect,
-			on_g_list_rect_free_func
-		);
-		page_data->find_rect = NULL;
-	}
-
+	page_data->find_index = -1;
+	page_data->find_rect = NULL;
 	page_data->find_rect_iter = NULL;
+	page_data->find_result = -1;
+	page_data->find_match = 0;
+	page_data->find_waiting = FALSE;
 
-	gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
+	invalidate_page (page_data);
+	update_find_count (page_data);
 }
 
 static void
@@ -3141,6 +3737,7 @@ on_notebook_page_added (GtkNotebook *notebook,
 					    guint        page_num,
 					    gpointer     user_data)
 {
+	GspdfAppPrivate *priv = gspdf_app_get_instance_private (GSPDF_APP (user_data));
 	GspdfPageData *page_data = g_malloc0 (sizeof (GspdfPageData));
 
 	page_data->window = (GtkWidget*) user_data;
@@ -3152,6 +3749,19 @@ on_notebook_page_added (GtkNotebook *notebook,
 	page_data->scale_mode = DEFAULT_SCALE_MODE_VALUE;
 	page_data->outline = gtk_tree_store_new (2, G_TYPE_STRING, G_TYPE_POINTER);
 	page_data->bookmark = gtk_tree_store_new (2, G_TYPE_STRING, G_TYPE_INT);
+	page_data->render_pending = g_array_new (FALSE, FALSE, sizeof (gint));
+
+	// rendered pages kept around by all tabs together, in MiB
+	gint budget = g_key_file_get_integer (
+		priv->config,
+		"settings",
+		"cache-budget",
+		NULL
+	);
+
+	if (budget > 0) {
+		gspdf_page_cache_set_budget (page_data->page_cache, (gsize) budget << 20);
+	}
 
 	g_object_set (G_OBJECT (child), "user-data", page_data, NULL);
 
@@ -3170,6 +3780,27 @@ on_notebook_page_added (GtkNotebook *notebook,
 		page_data
 	);
 
+	g_signal_connect (
+		G_OBJECT (page_data->page_cache),
+		"document-map-changed",
+		G_CALLBACK (on_page_cache_document_map_changed),
+		page_data
+	);
+
+	g_signal_connect (
+		G_OBJECT (page_data->page_cache),
+		"find-result",
+		G_CALLBACK (on_page_cache_find_result),
+		page_data
+	);
+
+	g_signal_connect (
+		G_OBJECT (page_data->page_cache),
+		"find-finished",
+		G_CALLBACK (on_page_cache_find_finished),
+		page_data
+	);
+
 	// drawing area
 	GtkWidget *drawing_area = NULL;
 	g_object_get (G_OBJECT (child), "drawing-area", &drawing_area, NULL);
@@ -3284,9 +3915,21 @@ on_notebook_page_switch (GtkNotebook *notebook,
 
 	reset_menu (GSPDF_APP (window));
 	reset_toolbar (GSPDF_APP (window));
+	update_find_toolbar (GSPDF_APP (window), page_data);
 
 	gtk_tree_view_set_model (GTK_TREE_VIEW (outline), GTK_TREE_MODEL (page_data->outline));
 	gtk_tree_view_set_model (GTK_TREE_VIEW (bookmark), GTK_TREE_MODEL (page_data->bookmark));
+
+	// the notebook still reports the previous page as current here
+	update_active_page (GSPDF_APP (window), page);
+}
+
+static void
+on_window_is_active_notify (GObject    *object,
+                            GParamSpec *pspec,
+                            gpointer    user_data)
+{
+	update_active_page (GSPDF_APP (object), get_current_page (GSPDF_APP (object)));
 }
 
 static void
@@ -3339,7 +3982,7 @@ on_close_menu_item_activate (GtkMenuItem *menuitem, gpointer user_data)
 
 	close_document (page_data);
 
-	gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
+	invalidate_page (page_data);
 }
 
 static void
@@ -3359,7 +4002,7 @@ on_next_menu_item_activate (GtkMenuItem *menuitem, gpointer user_data)
 
 	next_page (page_data);
 
-	gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
+	invalidate_page (page_data);
 }
 
 static void
@@ -3373,7 +4016,7 @@ on_prev_menu_item_activate (GtkMenuItem *menuitem, gpointer user_data)
 
 	prev_page (page_data);
 
-	gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
+	invalidate_page (page_data);
 }
 
 static void
@@ -3387,7 +4030,7 @@ on_first_menu_item_activate (GtkMenuItem *menuitem, gpointer user_data)
 
 	first_page (page_data);
 
-	gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
+	invalidate_page (page_data);
 }
 
 static void
@@ -3401,7 +4044,7 @@ on_last_menu_item_activate (GtkMenuItem *menuitem, gpointer user_data)
 
 	last_page (page_data);
 
-	gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
+	invalidate_page (page_data);
 }
 
 static void
@@ -3433,7 +4076,7 @@ on_cont_menu_item_toggled (GtkCheckMenuItem *checkmenuitem, gpointer user_data)
 
 	}
 
-	gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
+	invalidate_page (page_data);
 }
 
 static void
@@ -3723,21 +4366,29 @@ on_page_drawing_area_draw (GtkWidget *widget, cairo_t *cr, gpointer user_data)
 {
 	GspdfPageData *page_data = (GspdfPageData*) user_data;
 
-	cairo_set_source_rgba (cr, 0, 0, 0, 0.4);
+	if (!page_data->document) {
+		cairo_set_source_rgba (cr, 0, 0, 0, 0.4);
 
-	cairo_rectangle (
-		cr, 0, 0,
-		gtk_widget_get_allocated_width (widget),
-		gtk_widget_get_allocated_height (widget)
-	);
+		cairo_rectangle (
+			cr, 0, 0,
+			gtk_widget_get_allocated_width (widget),
+			gtk_widget_get_allocated_height (widget)
+		);
 
-	cairo_fill (cr);
+		cairo_fill (cr);
 
-	if (!page_data->document) {
 		return FALSE;
 	}
 
-	draw_page (page_data, widget, cr);
+	gspdf_page_cache_set_window (
+		page_data->page_cache,
+		gtk_widget_get_window (widget)
+	);
+
+	update_backing (page_data, widget);
+
+	cairo_set_source_surface (cr, page_data->backing, 0, 0);
+	cairo_paint (cr);
 
 	return TRUE;
 }
@@ -3861,7 +4512,7 @@ on_page_cache_document_load_finished (GObject *object, gpointer user_data)
 			update_page_range (page_data, page_data->index, page_data->index);
 		}
 
-		gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
+		invalidate_page (page_data);
 	} else {
 		if (err) {
 			handle_document_error (page_data, err);
@@ -3871,14 +4522,129 @@ on_page_cache_document_load_finished (GObject *object, gpointer user_data)
 }
 
 static void
-on_page_cache_document_render_finished (GObject *object, gpointer user_data)
+on_page_cache_document_render_finished (GObject  *object,
+                                        gpointer  pages,
+                                        gpointer  user_data)
 {
 	g_return_if_fail (GSPDF_IS_PAGE_CACHE (object));
 	g_return_if_fail (user_data != NULL);
 
 	GspdfPageData *page_data = (GspdfPageData*) user_data;
+	GArray *indices = (GArray*) pages;
 
-	gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
+	g_array_append_vals (page_data->render_pending, indices->data, indices->len);
+
+	if (page_data->render_tick != 0) {
+		return;
+	}
+
+	// redraw once on the next frame, whatever finishes until then
+	GtkWidget *drawing_area = NULL;
+	g_object_get (G_OBJECT (page_data->page), "drawing-area", &drawing_area, NULL);
+	g_object_unref (drawing_area);
+
+	page_data->render_tick = gtk_widget_add_tick_callback (
+		drawing_area,
+		on_page_drawing_area_tick,
+		page_data,
+		NULL
+	);
+}
+
+// estimated page sizes were replaced by measured ones, keep the page at
+// the top of the view where it is
+static void
+on_page_cache_document_map_changed (GObject  *object,
+                                    gint      start,
+                                    gint      end,
+                                    gpointer  user_data)
+{
+	GspdfPageData *page_data = (GspdfPageData*) user_data;
+
+	if (!page_data->document || !page_data->doc_map) {
+		return;
+	}
+
+	const gdouble scale = page_data->scale;
+	gint anchor = -1;
+	gdouble delta = 0;
+
+	if (page_data->layout) {
+		const gdouble y_value = get_vscroll_value (page_data);
+
+		anchor = gspdf_page_layout_get_page_at (page_data->layout, y_value);
+
+		if (anchor >= 0) {
+			delta = y_value - gspdf_page_layout_get_offset (page_data->layout, anchor);
+		}
+
+		gspdf_page_layout_update (page_data->layout, start);
+	}
+
+	update_page (page_data);
+
+	if (page_data->continuous && (anchor >= 0)) {
+		update_vscroll_value_block (
+			page_data,
+			get_page_y_offset (page_data, anchor) + (delta * page_data->scale / scale)
+		);
+
+		scroll_page (page_data);
+	}
+}
+
+static void
+on_page_cache_find_result (GObject  *object,
+                           gint      n,
+                           gpointer  user_data)
+{
+	GspdfPageData *page_data = (GspdfPageData*) user_data;
+
+	if (page_data->find_waiting) {
+		page_data->find_waiting = FALSE;
+		show_find_result (page_data, n);
+	} else {
+		update_find_count (page_data);
+	}
+}
+
+// nothing more after the last result, go round to the first one
+static void
+on_page_cache_find_finished (GObject  *object,
+                             gpointer  user_data)
+{
+	GspdfPageData *page_data = (GspdfPageData*) user_data;
+
+	if (!page_data->find_waiting) {
+		return;
+	}
+
+	page_data->find_waiting = FALSE;
+
+	if (gspdf_page_cache_get_n_find_results (page_data->page_cache) > 0) {
+		show_find_result (page_data, 0);
+	}
+}
+
+static gboolean
+on_page_drawing_area_tick (GtkWidget     *widget,
+                           GdkFrameClock *frame_clock,
+                           gpointer       user_data)
+{
+	GspdfPageData *page_data = (GspdfPageData*) user_data;
+
+	// pages off screen, prefetched ones, invalidate nothing
+	for (guint i = 0; i < page_data->render_pending->len; i++) {
+		invalidate_page_index (
+			page_data,
+			g_array_index (page_data->render_pending, gint, i)
+		);
+	}
+
+	g_array_set_size (page_data->render_pending, 0);
+	page_data->render_tick = 0;
+
+	return G_SOURCE_REMOVE;
 }
 
 static gboolean
@@ -4026,140 +4792,103 @@ _list_page_selection_free_func (gpointer data)
 }
 
 static void
-_list_text_mapping_free_func (gpointer data)
+_set_pointer_mode (GspdfPageData *page_data,
+                   gint           pointer_mode)
 {
-	GspdfDocLinkMapping *link_mapping = (GspdfDocLinkMapping*) data;
+	if (page_data->pointer_mode == pointer_mode) {
+		return;
+	}
 
-	if (link_mapping->action) {
+	GdkWindow *window = gtk_widget_get_window (page_data->window);
+	GdkCursor *cursor = NULL;
+
+	if (pointer_mode == POINTER_MODE_LINK) {
+		cursor = gdk_cursor_new_for_display (gdk_window_get_display (window), GDK_HAND2);
+	} else if (pointer_mode == POINTER_MODE_TEXT) {
+		cursor = gdk_cursor_new_for_display (gdk_window_get_display (window), GDK_XTERM);
+	}
 
-		gspdf_doc_action_free (link_mapping->action);
+	gdk_window_set_cursor (window, cursor);
 
+	if (cursor) {
+		g_object_unref (cursor);
 	}
 
-	g_free (link_mapping);
+	page_data->pointer_mode = pointer_mode;
 }
 
-static void
-_update_cursor (GspdfPageData  *page_data,
-				GdkEventMotion *event)
+// the link under the pointer, NULL until the page's hit index is built
+static const GspdfDocLinkMapping *
+_get_link_at (GspdfPageData *page_data,
+              gdouble        event_x,
+              gdouble        event_y)
 {
 	gint index = -1;
 	gdouble x = -1, y  = -1;
 
-	if (!get_current_pointer_position (page_data, event->x, event->y, &index, &x, &y)) {
-
-		return;
-
+	if (!get_current_pointer_position (page_data, event_x, event_y, &index, &x, &y)) {
+		return NULL;
 	}
 
 	if ((index < 0) || (x < 0) || (y < 0)) {
-
-		return;
-
+		return NULL;
 	}
 
-	// link
-	GspdfDocumentPage *doc_page = gspdf_document_get_page (page_data->document, index);
-	GList *links = gspdf_document_page_get_link_mapping (doc_page);
-
-	g_object_unref (doc_page);
-
-	if (links) {
-
-		GspdfDocLinkMapping *link_mapping = NULL;
-		GList *links_iter = links;
-
-		while (links_iter) {
-
-			link_mapping = (GspdfDocLinkMapping*) links_iter->data;
-
-			if ((x > (link_mapping->area.x * page_data->scale)) &&
-				(y > (link_mapping->area.y  * page_data->scale)) &&
-				(x < ((link_mapping->area.x  * page_data->scale) +
-					 (link_mapping->area.width  * page_data->scale))) &&
-				(y < ((link_mapping->area.y  * page_data->scale) +
-				      (link_mapping->area.height  * page_data->scale))))
-			{
-
-				GdkWindow *window = gtk_widget_get_window (page_data->window);
-
-				GdkCursor *cursor = gdk_cursor_new_for_display (
-					gdk_window_get_display (window), GDK_HAND2
-				);
-
-				gdk_window_set_cursor (window, cursor);
-
-				page_data->pointer_mode = POINTER_MODE_LINK;
-
-				if (page_data->link_action) {
-
-					gspdf_doc_action_free (page_data->link_action);
-
-					page_data->link_action = NULL;
-
-				}
-
-				page_data->link_action = gspdf_doc_action_copy (link_mapping->action);
-
-				g_object_unref (cursor);
-
-				g_list_free_full (links, _list_text_mapping_free_func);
-
-				return;
-
-			}
-
-			links_iter = links_iter->next;
-
-		}
+	const GspdfHitIndex *hit_index = gspdf_page_cache_get_hit_index (
+		page_data->page_cache,
+		index
+	);
 
+	if (!hit_index) {
+		return NULL;
 	}
 
-	// text
-
-	GList *text_mapping = gspdf_page_cache_get_text_mapping (page_data->page_cache, index);
-
-	if (text_mapping) {
-
-		GList *text_mapping_iter = text_mapping;
-
-		while (text_mapping_iter) {
+	return gspdf_hit_index_get_link_at (
+		hit_index,
+		x / page_data->scale,
+		y / page_data->scale
+	);
+}
 
-			if ((x > (((GspdfRectangle*)text_mapping_iter->data)->x * page_data->scale)) &&
-				(y > (((GspdfRectangle*)text_mapping_iter->data)->y * page_data->scale)) &&
-				(x < ((((GspdfRectangle*)text_mapping_iter->data)->x * page_data->scale) +
-					 (((GspdfRectangle*)text_mapping_iter->data)->width * page_data->scale))) &&
-				(y < ((((GspdfRectangle*)text_mapping_iter->data)->y * page_data->scale) +
-				      (((GspdfRectangle*)text_mapping_iter->data)->height * page_data->scale))))
-			{
+// runs for every motion event, only looks up the page's hit index
+static void
+_update_cursor (GspdfPageData  *page_data,
+				GdkEventMotion *event)
+{
+	gint index = -1;
+	gdouble x = -1, y  = -1;
 
-				GdkWindow *window = gtk_widget_get_window (page_data->window);
+	if (!get_current_pointer_position (page_data, event->x, event->y, &index, &x, &y)) {
 
-				GdkCursor *cursor = gdk_cursor_new_for_display (
-					gdk_window_get_display (window), GDK_XTERM
-				);
+		return;
 
-				gdk_window_set_cursor (window, cursor);
+	}
 
-				page_data->pointer_mode = POINTER_MODE_TEXT;
+	if ((index < 0) || (x < 0) || (y < 0)) {
 
-				g_object_unref (cursor);
+		return;
 
-				//g_list_free_full (text_mapping, _list_selection_free_func);
+	}
 
-				return;
+	const GspdfHitIndex *hit_index = gspdf_page_cache_get_hit_index (
+		page_data->page_cache,
+		index
+	);
 
-			}
+	gint pointer_mode = POINTER_MODE_NORMAL;
 
-			text_mapping_iter = text_mapping_iter->next;
+	if (hit_index) {
+		x /= page_data->scale;
+		y /= page_data->scale;
 
+		if (gspdf_hit_index_get_link_at (hit_index, x, y)) {
+			pointer_mode = POINTER_MODE_LINK;
+		} else if (gspdf_hit_index_has_text_at (hit_index, x, y)) {
+			pointer_mode = POINTER_MODE_TEXT;
 		}
-
 	}
 
-	gdk_window_set_cursor (gtk_widget_get_window (page_data->window), NULL);
-
-	page_data->pointer_mode = POINTER_MODE_NORMAL;
+	_set_pointer_mode (page_data, pointer_mode);
 
 }
 
@@ -4170,7 +4899,7 @@ on_page_drawing_area_leave (GtkWidget        *widget,
 {
 	GspdfPageData *page_data = (GspdfPageData*) user_data;
 
-	gdk_window_set_cursor (gtk_widget_get_window (page_data->window), NULL);
+	_set_pointer_mode (page_data, POINTER_MODE_NORMAL);
 
 	return FALSE;
 }
@@ -4196,6 +4925,7 @@ on_page_drawing_area_motion (GtkWidget       *widget,
 	}
 
 	if (page_data->selection) {
+		invalidate_selection (page_data);
 		g_list_free_full (page_data->selection, _list_page_selection_free_func);
 	}
 
@@ -4210,7 +4940,7 @@ on_page_drawing_area_motion (GtkWidget       *widget,
 
 	page_data->selection = get_selected_page_area (page_data, &area);
 
-	gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
+	invalidate_selection (page_data);
 
 	return TRUE;
 }
@@ -4232,19 +4962,29 @@ on_page_drawing_button_press (GtkWidget       *widget,
 	if (event->button == 1) {
 		// link
 		if (page_data->pointer_mode == POINTER_MODE_LINK) {
-			if (page_data->link_action) {
-				process_action (page_data, page_data->link_action);
+			const GspdfDocLinkMapping *link = _get_link_at (
+				page_data,
+				event->x,
+				event->y
+			);
+
+			// the hit index may go away while the action runs
+			if (link && link->action) {
+				GspdfDocAction *action = gspdf_doc_action_copy (link->action);
+				process_action (page_data, action);
+				gspdf_doc_action_free (action);
 			}
+
 			return TRUE;
 		}
 
 		// selection
 		if (page_data->selection) {
+			invalidate_selection (page_data);
 			g_list_free_full (
 				page_data->selection,
 				_list_page_selection_free_func
 			);
-			gspdf_page_queue_draw (GSPDF_PAGE (page_data->page));
 		}
 
 		page_data->selection = NULL;
@@ -15,6 +15,10 @@
 
 #include "gspdf-document-page.h"
 
+#include "../gspdf-util/gspdf-buffer-pool.h"
+
+#include <math.h>
+
 typedef struct {
 	gpointer *handler;
 } GspdfDocumentPagePrivate;
@@ -140,15 +144,106 @@ gspdf_document_page_get_height (GspdfDocumentPage *doc_page)
 	return GSPDF_DOCUMENT_PAGE_GET_CLASS (doc_page)->get_height (doc_page);
 }
 
-GdkPixbuf *
+cairo_surface_t *
 gspdf_document_page_render (GspdfDocumentPage *doc_page, gdouble sx, gdouble sy)
 {
 
 	g_return_val_if_fail (doc_page != NULL, NULL);
 	g_return_val_if_fail (GSPDF_IS_DOCUMENT_PAGE (doc_page), NULL);
-	g_return_val_if_fail (GSPDF_DOCUMENT_PAGE_GET_CLASS (doc_page)->render != NULL, NULL);
 
-	return GSPDF_DOCUMENT_PAGE_GET_CLASS (doc_page)->render (doc_page, sx, sy);
+	// backends implementing only render_region get whole pages from it
+	if (GSPDF_DOCUMENT_PAGE_GET_CLASS (doc_page)->render) {
+		return GSPDF_DOCUMENT_PAGE_GET_CLASS (doc_page)->render (doc_page, sx, sy);
+	}
+
+	const GspdfRectangle area = {
+		0,
+		0,
+		ceil (gspdf_document_page_get_width (doc_page) * sx),
+		ceil (gspdf_document_page_get_height (doc_page) * sy)
+	};
+
+	return gspdf_document_page_render_area (doc_page, sx, sy, &area);
+}
+
+// region is in pixels of the page rendered at sx, sy, data is an RGB24
+// buffer of region's size owned by the caller
+gboolean
+gspdf_document_page_render_region (GspdfDocumentPage    *doc_page,
+	                                 gdouble               sx,
+	                                 gdouble               sy,
+	                                 const GspdfRectangle *region,
+	                                 guchar               *data,
+	                                 gint                  stride)
+{
+	g_return_val_if_fail (doc_page != NULL, FALSE);
+	g_return_val_if_fail (GSPDF_IS_DOCUMENT_PAGE (doc_page), FALSE);
+	g_return_val_if_fail (region != NULL, FALSE);
+	g_return_val_if_fail (data != NULL, FALSE);
+	g_return_val_if_fail (GSPDF_DOCUMENT_PAGE_GET_CLASS (doc_page)->render_region != NULL, FALSE);
+
+	return GSPDF_DOCUMENT_PAGE_GET_CLASS (doc_page)->render_region (
+		doc_page,
+		sx,
+		sy,
+		region,
+		data,
+		stride
+	);
+}
+
+static const cairo_user_data_key_t _buffer_key;
+
+static void
+_buffer_release_func (void *data)
+{
+	gspdf_buffer_pool_release (gspdf_buffer_pool_get_default (), data);
+}
+
+// like render_region, into a new opaque image surface whose memory comes
+// from the default buffer pool and goes back to it with the surface
+cairo_surface_t *
+gspdf_document_page_render_area (GspdfDocumentPage    *doc_page,
+	                               gdouble               sx,
+	                               gdouble               sy,
+	                               const GspdfRectangle *area)
+{
+	g_return_val_if_fail (area != NULL, NULL);
+
+	const gint width = (gint) ceil (area->width);
+	const gint height = (gint) ceil (area->height);
+
+	g_return_val_if_fail ((width > 0) && (height > 0), NULL);
+
+	const gint stride = cairo_format_stride_for_width (CAIRO_FORMAT_RGB24, width);
+	GspdfBufferPool *pool = gspdf_buffer_pool_get_default ();
+	guchar *data = gspdf_buffer_pool_acquire (pool, (gsize) stride * height);
+
+	if (!gspdf_document_page_render_region (doc_page, sx, sy, area, data, stride)) {
+		gspdf_buffer_pool_release (pool, data);
+		return NULL;
+	}
+
+	cairo_surface_t *surface = cairo_image_surface_create_for_data (
+		data,
+		CAIRO_FORMAT_RGB24,
+		width,
+		height,
+		stride
+	);
+
+	if (cairo_surface_set_user_data (
+		surface,
+		&_buffer_key,
+		data,
+		_buffer_release_func) != CAIRO_STATUS_SUCCESS)
+	{
+		cairo_surface_destroy (surface);
+		gspdf_buffer_pool_release (pool, data);
+		return NULL;
+	}
+
+	return surface;
 }
 
 GList *
@@ -197,6 +292,32 @@ gspdf_document_page_find_text (GspdfDocumentPage *doc_page,
 	return GSPDF_DOCUMENT_PAGE_GET_CLASS (doc_page)->find_text (doc_page, text, options);
 }
 
+gchar *
+gspdf_document_page_get_text (GspdfDocumentPage *doc_page)
+{
+	g_return_val_if_fail (doc_page != NULL, NULL);
+	g_return_val_if_fail (GSPDF_IS_DOCUMENT_PAGE (doc_page), NULL);
+	g_return_val_if_fail (GSPDF_DOCUMENT_PAGE_GET_CLASS (doc_page)->get_text != NULL, NULL);
+
+	return GSPDF_DOCUMENT_PAGE_GET_CLASS (doc_page)->get_text (doc_page);
+}
+
+// the box of every character of get_text, in page units, rects is
+// freed with g_free
+gboolean
+gspdf_document_page_get_text_layout (GspdfDocumentPage  *doc_page,
+	                                   GspdfRectangle    **rects,
+	                                   guint              *n_rects)
+{
+	g_return_val_if_fail (doc_page != NULL, FALSE);
+	g_return_val_if_fail (GSPDF_IS_DOCUMENT_PAGE (doc_page), FALSE);
+	g_return_val_if_fail (rects != NULL, FALSE);
+	g_return_val_if_fail (n_rects != NULL, FALSE);
+	g_return_val_if_fail (GSPDF_DOCUMENT_PAGE_GET_CLASS (doc_page)->get_text_layout != NULL, FALSE);
+
+	return GSPDF_DOCUMENT_PAGE_GET_CLASS (doc_page)->get_text_layout (doc_page, rects, n_rects);
+}
+
 /**
  * GspdfDocLinkMapping
  */
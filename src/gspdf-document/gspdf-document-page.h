@@ -20,8 +20,8 @@
 #include <glib-object.h>
 #endif
 
-#ifndef GDK_PIXBUF_H
-#include <gdk-pixbuf/gdk-pixbuf.h>
+#ifndef CAIRO_H
+#include <cairo.h>
 #endif
 
 G_BEGIN_DECLS
@@ -70,7 +70,7 @@ struct _GspdfDocumentPageClass {
 
 	gdouble (*get_height) (GspdfDocumentPage *doc_page);
 
-	GdkPixbuf *(*render) (GspdfDocumentPage *doc_page,
+	cairo_surface_t *(*render) (GspdfDocumentPage *doc_page,
 						            gdouble            sx,
 						            gdouble            sy);
 
@@ -90,7 +90,20 @@ struct _GspdfDocumentPageClass {
 						           const gchar       *text,
 						           GspdfFindFlags     options);
 
-	gpointer padding[12];
+	gboolean (*render_region) (GspdfDocumentPage    *doc_page,
+	                           gdouble               sx,
+	                           gdouble               sy,
+	                           const GspdfRectangle *region,
+	                           guchar               *data,
+	                           gint                  stride);
+
+	gchar *(*get_text) (GspdfDocumentPage *doc_page);
+
+	gboolean (*get_text_layout) (GspdfDocumentPage  *doc_page,
+	                             GspdfRectangle    **rects,
+	                             guint              *n_rects);
+
+	gpointer padding[9];
 };
 
 gint
@@ -105,7 +118,7 @@ gspdf_document_page_get_width (GspdfDocumentPage *doc_page);
 gdouble
 gspdf_document_page_get_height (GspdfDocumentPage *doc_page);
 
-GdkPixbuf *
+cairo_surface_t *
 gspdf_document_page_render (GspdfDocumentPage *doc_page,
 						                gdouble            sx,
 						                gdouble            sy);
@@ -131,6 +144,28 @@ gspdf_document_page_find_text (GspdfDocumentPage *doc_page,
 						                   const gchar       *text,
 						                   GspdfFindFlags     options);
 
+gchar *
+gspdf_document_page_get_text (GspdfDocumentPage *doc_page);
+
+gboolean
+gspdf_document_page_get_text_layout (GspdfDocumentPage  *doc_page,
+	                                   GspdfRectangle    **rects,
+	                                   guint              *n_rects);
+
+gboolean
+gspdf_document_page_render_region (GspdfDocumentPage    *doc_page,
+	                                 gdouble               sx,
+	                                 gdouble               sy,
+	                                 const GspdfRectangle *region,
+	                                 guchar               *data,
+	                                 gint                  stride);
+
+cairo_surface_t *
+gspdf_document_page_render_area (GspdfDocumentPage    *doc_page,
+	                               gdouble               sx,
+	                               gdouble               sy,
+	                               const GspdfRectangle *area);
+
 /**
  * GspdfDocLinkMapping
  */
@@ -424,6 +424,33 @@ gspdf_document_get_n_attachments (GspdfDocument *doc)
 	return GSPDF_DOCUMENT_GET_CLASS (doc)->get_n_attachments (doc);
 }
 
+gboolean
+gspdf_document_is_encrypted (GspdfDocument *doc)
+{
+	g_return_val_if_fail (doc != NULL, FALSE);
+	g_return_val_if_fail (GSPDF_IS_DOCUMENT (doc), FALSE);
+	g_return_val_if_fail (
+		GSPDF_DOCUMENT_GET_CLASS (doc)->is_encrypted != NULL,
+		FALSE
+	);
+
+	return GSPDF_DOCUMENT_GET_CLASS (doc)->is_encrypted (doc);
+}
+
+// gets the document ready for pages to be taken from several threads at
+// once, which may take as long as opening it did. Documents that need
+// nothing for it leave open_handles unset.
+void
+gspdf_document_open_handles (GspdfDocument *doc)
+{
+	g_return_if_fail (doc != NULL);
+	g_return_if_fail (GSPDF_IS_DOCUMENT (doc));
+
+	if (GSPDF_DOCUMENT_GET_CLASS (doc)->open_handles) {
+		GSPDF_DOCUMENT_GET_CLASS (doc)->open_handles (doc);
+	}
+}
+
 /**
  * GspdfDocOutline
  */
@@ -88,7 +88,11 @@ struct _GspdfDocumentClass {
 
 	guint (*get_n_attachments) (GspdfDocument *doc);
 
-	gpointer padding[12];
+	gboolean (*is_encrypted) (GspdfDocument *doc);
+
+	void (*open_handles) (GspdfDocument *doc);
+
+	gpointer padding[10];
 };
 
 gboolean
@@ -119,6 +123,12 @@ gspdf_document_has_attachments (GspdfDocument *doc);
 guint
 gspdf_document_get_n_attachments (GspdfDocument *doc);
 
+gboolean
+gspdf_document_is_encrypted (GspdfDocument *doc);
+
+void
+gspdf_document_open_handles (GspdfDocument *doc);
+
 
 
 /**
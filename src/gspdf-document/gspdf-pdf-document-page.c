@@ -22,7 +22,11 @@
 #include <math.h>
 
 struct _GspdfPdfDocumentPage {
-	GspdfDocumentPage parent;
+	GspdfDocumentPage       parent;
+
+	GspdfPdfDocument       *document;
+	// the poppler handle the page was loaded from, guards every call on it
+	GspdfPdfDocumentHandle *handle;
 };
 
 G_DEFINE_TYPE (
@@ -37,6 +41,18 @@ on_g_list_poppler_rect_free_func (gpointer data)
 	poppler_rectangle_free ((PopplerRectangle*)data);
 }
 
+static void
+_lock (GspdfDocumentPage *doc_page)
+{
+	gspdf_pdf_document_handle_lock (GSPDF_PDF_DOCUMENT_PAGE (doc_page)->handle);
+}
+
+static void
+_unlock (GspdfDocumentPage *doc_page)
+{
+	gspdf_pdf_document_handle_unlock (GSPDF_PDF_DOCUMENT_PAGE (doc_page)->handle);
+}
+
 static gint
 gspdf_pdf_document_page_get_index (GspdfDocumentPage *doc_page)
 {
@@ -44,7 +60,11 @@ gspdf_pdf_document_page_get_index (GspdfDocumentPage *doc_page)
 	g_object_get (G_OBJECT (doc_page), "handler", &handler, NULL);
 	g_return_val_if_fail (handler != NULL, -1);
 
-	return poppler_page_get_index (handler);
+	_lock (doc_page);
+	gint ret = poppler_page_get_index (handler);
+	_unlock (doc_page);
+
+	return ret;
 }
 
 static gchar *
@@ -54,7 +74,11 @@ gspdf_pdf_document_page_get_label (GspdfDocumentPage *doc_page)
 	g_object_get (G_OBJECT (doc_page), "handler", &handler, NULL);
 	g_return_val_if_fail (handler != NULL, NULL);
 
-	return poppler_page_get_label (handler);
+	_lock (doc_page);
+	gchar *ret = poppler_page_get_label (handler);
+	_unlock (doc_page);
+
+	return ret;
 }
 
 static gdouble
@@ -65,7 +89,9 @@ gspdf_pdf_document_page_get_width (GspdfDocumentPage *doc_page)
 	g_return_val_if_fail (handler != NULL, -1);
 
 	gdouble ret = -1;
+	_lock (doc_page);
 	poppler_page_get_size (handler, &ret, NULL);
+	_unlock (doc_page);
 
 	return ret;
 }
@@ -78,65 +104,56 @@ gspdf_pdf_document_page_get_height (GspdfDocumentPage *doc_page)
 	g_return_val_if_fail (handler != NULL, -1);
 
 	gdouble ret = -1;
+	_lock (doc_page);
 	poppler_page_get_size (handler, NULL, &ret);
+	_unlock (doc_page);
 
 	return ret;
 }
 
-static void
-_pixbuf_destroy_notify_func (guchar *pixels, gpointer data)
-{
-	g_free (pixels);
-}
-
-static GdkPixbuf *
-gspdf_pdf_document_page_render (GspdfDocumentPage *doc_page,
-	                              gdouble            sx,
-															  gdouble            sy)
+// draws the region of the page scaled by sx, sy into data, an RGB24
+// buffer of region's size
+static gboolean
+gspdf_pdf_document_page_render_region (GspdfDocumentPage    *doc_page,
+	                                     gdouble               sx,
+	                                     gdouble               sy,
+	                                     const GspdfRectangle *region,
+	                                     guchar               *data,
+	                                     gint                  stride)
 {
 	PopplerPage *handler = NULL;
 	g_object_get (G_OBJECT (doc_page), "handler", &handler, NULL);
-	g_return_val_if_fail (handler != NULL, NULL);
+	g_return_val_if_fail (handler != NULL, FALSE);
 
-	const gdouble original_width = gspdf_document_page_get_width (doc_page);
-	const gdouble original_height = gspdf_document_page_get_height (doc_page);
-	const gdouble scaled_width = ceil (original_width * sx);
-	const gdouble scaled_height = ceil (original_height * sy);
-	const gdouble stride = scaled_width * 4;
-	const gsize scaled_width_blk = (gsize) scaled_width;
-	const gsize scaled_height_blk = (gsize) scaled_height;
-	const gsize stride_blk = (gsize) stride;
+	const gint width = (gint) ceil (region->width);
+	const gint height = (gint) ceil (region->height);
+
+	g_return_val_if_fail ((width > 0) && (height > 0), FALSE);
 
-	guchar *data = g_malloc0 (stride_blk * scaled_height_blk);
 	cairo_surface_t *surface = cairo_image_surface_create_for_data(
 		data,
-		CAIRO_FORMAT_ARGB32,
-		scaled_width_blk,
-		scaled_height_blk,
-		stride_blk
+		CAIRO_FORMAT_RGB24,
+		width,
+		height,
+		stride
 	);
 	cairo_t *ctx = cairo_create (surface);
 
+	cairo_rectangle (ctx, 0, 0, width, height);
+	cairo_clip (ctx);
 	cairo_set_source_rgb (ctx, 1.0, 1.0, 1.0);
-	cairo_rectangle (ctx, 0, 0, scaled_width_blk, scaled_height_blk);
-	cairo_fill (ctx);
+	cairo_paint (ctx);
+	cairo_translate (ctx, -floor (region->x), -floor (region->y));
 	cairo_scale (ctx, sx, sy);
+	_lock (doc_page);
 	poppler_page_render (handler, ctx);
+	_unlock (doc_page);
 
-	cairo_surface_destroy (surface);
 	cairo_destroy (ctx);
+	cairo_surface_flush (surface);
+	cairo_surface_destroy (surface);
 
-	return gdk_pixbuf_new_from_data (
-		data,
-		GDK_COLORSPACE_RGB,
-		TRUE,
-		8,
-		scaled_width_blk,
-		scaled_height_blk,
-		stride_blk,
-		_pixbuf_destroy_notify_func,
-		NULL
-	);
+	return TRUE;
 }
 
 static GList *
@@ -163,12 +180,14 @@ gspdf_pdf_document_page_get_selected_region (GspdfDocumentPage    *doc_page,
 		selection->y + selection->height
 	};
 
+	_lock (doc_page);
 	cairo_region_t *cairo_regions = poppler_page_get_selected_region (
 		handler,
 		1.0,
 		poppler_style,
 		&selection_area
 	);
+	_unlock (doc_page);
 
 	if (!cairo_regions) {
 		return NULL;
@@ -217,11 +236,15 @@ gspdf_pdf_document_page_get_selected_text (GspdfDocumentPage    *doc_page,
 		selection->y + selection->height
 	};
 
-	return poppler_page_get_selected_text (
+	_lock (doc_page);
+	gchar *ret = poppler_page_get_selected_text (
 		handler,
 		poppler_style,
 		&selection_area
 	);
+	_unlock (doc_page);
+
+	return ret;
 }
 
 
@@ -309,8 +332,11 @@ gspdf_pdf_document_page_get_link_mapping (GspdfDocumentPage *doc_page)
 	g_object_get (G_OBJECT (doc_page), "handler", &handler, NULL);
 	g_return_val_if_fail (handler != NULL, NULL);
 
+	_lock (doc_page);
+
 	GList *links = poppler_page_get_link_mapping (handler);
 	if (!links) {
+		_unlock (doc_page);
 		return NULL;
 	}
 
@@ -341,6 +367,8 @@ gspdf_pdf_document_page_get_link_mapping (GspdfDocumentPage *doc_page)
 
 	poppler_page_free_link_mapping (links);
 
+	_unlock (doc_page);
+
 	return ret;
 }
 
@@ -371,19 +399,23 @@ gspdf_pdf_document_page_find_text (GspdfDocumentPage *doc_page,
 		poppler_find_flags |= POPPLER_FIND_WHOLE_WORDS_ONLY;
 	}
 
+	_lock (doc_page);
+
 	GList *texts = poppler_page_find_text_with_options (
 		handler,
 		text,
 		poppler_find_flags
 	);
 
+	gdouble width = -1, height = -1;
+	poppler_page_get_size (handler, &width, &height);
+
+	_unlock (doc_page);
+
 	if (!texts) {
 		return NULL;
 	}
 
-	gdouble width = -1, height = -1;
-	poppler_page_get_size (handler, &width, &height);
-
 	GList *iter = texts;
 	GList *ret = NULL;
 	PopplerRectangle *poppler_rect = NULL;
@@ -407,14 +439,76 @@ gspdf_pdf_document_page_find_text (GspdfDocumentPage *doc_page,
 	return ret;
 }
 
+static gchar *
+gspdf_pdf_document_page_get_text (GspdfDocumentPage *doc_page)
+{
+	PopplerPage *handler = NULL;
+	g_object_get (G_OBJECT (doc_page), "handler", &handler, NULL);
+	g_return_val_if_fail (handler != NULL, NULL);
+
+	_lock (doc_page);
+	gchar *ret = poppler_page_get_text (handler);
+	_unlock (doc_page);
+
+	return ret;
+}
+
+static gboolean
+gspdf_pdf_document_page_get_text_layout (GspdfDocumentPage  *doc_page,
+	                                       GspdfRectangle    **rects,
+	                                       guint              *n_rects)
+{
+	PopplerPage *handler = NULL;
+	g_object_get (G_OBJECT (doc_page), "handler", &handler, NULL);
+	g_return_val_if_fail (handler != NULL, FALSE);
+
+	PopplerRectangle *poppler_rects = NULL;
+	guint n = 0;
+
+	_lock (doc_page);
+	const gboolean ret = poppler_page_get_text_layout (handler, &poppler_rects, &n);
+	_unlock (doc_page);
+
+	if (!ret) {
+		return FALSE;
+	}
+
+	*rects = g_malloc (MAX (n, 1) * sizeof (GspdfRectangle));
+	*n_rects = n;
+
+	// the layout's origin is already the top left corner
+	for (guint i = 0; i < n; i++) {
+		(*rects)[i].x = poppler_rects[i].x1;
+		(*rects)[i].y = poppler_rects[i].y1;
+		(*rects)[i].width = poppler_rects[i].x2 - poppler_rects[i].x1;
+		(*rects)[i].height = poppler_rects[i].y2 - poppler_rects[i].y1;
+	}
+
+	g_free (poppler_rects);
+
+	return TRUE;
+}
+
 static void
 gspdf_pdf_document_page_dispose (GObject *object)
 {
 	PopplerPage *handler = NULL;
 	g_object_get (G_OBJECT (object), "handler", &handler, NULL);
 
+	GspdfPdfDocumentPage *self = GSPDF_PDF_DOCUMENT_PAGE (object);
+
 	if (handler != NULL) {
+		gspdf_pdf_document_handle_lock (self->handle);
 		g_object_unref (handler);
+		gspdf_pdf_document_handle_unlock (self->handle);
+		g_object_set (G_OBJECT (object), "handler", NULL, NULL);
+	}
+
+	if (self->document) {
+		gspdf_pdf_document_release_handle (self->document, self->handle);
+		self->handle = NULL;
+		g_object_unref (self->document);
+		self->document = NULL;
 	}
 
 	G_OBJECT_CLASS (gspdf_pdf_document_page_parent_class)->dispose (object);
@@ -445,9 +539,32 @@ gspdf_pdf_document_page_class_init (GspdfPdfDocumentPageClass *klass)
 	parent->get_label = gspdf_pdf_document_page_get_label;
 	parent->get_width = gspdf_pdf_document_page_get_width;
 	parent->get_height = gspdf_pdf_document_page_get_height;
-	parent->render = gspdf_pdf_document_page_render;
 	parent->get_selected_region = gspdf_pdf_document_page_get_selected_region;
 	parent->get_selected_text = gspdf_pdf_document_page_get_selected_text;
 	parent->get_link_mapping = gspdf_pdf_document_page_get_link_mapping;
 	parent->find_text = gspdf_pdf_document_page_find_text;
+	parent->render_region = gspdf_pdf_document_page_render_region;
+	parent->get_text = gspdf_pdf_document_page_get_text;
+	parent->get_text_layout = gspdf_pdf_document_page_get_text_layout;
+}
+
+GspdfDocumentPage *
+gspdf_pdf_document_page_new (GspdfDocument          *document,
+                             GspdfPdfDocumentHandle *handle,
+                             gpointer                handler)
+{
+	g_return_val_if_fail (GSPDF_IS_PDF_DOCUMENT (document), NULL);
+	g_return_val_if_fail (handle != NULL, NULL);
+	g_return_val_if_fail (handler != NULL, NULL);
+
+	GspdfPdfDocumentPage *doc_page = g_object_new (
+		GSPDF_TYPE_PDF_DOCUMENT_PAGE,
+		NULL
+	);
+
+	doc_page->document = g_object_ref (document);
+	doc_page->handle = handle;
+	g_object_set (G_OBJECT (doc_page), "handler", handler, NULL);
+
+	return GSPDF_DOCUMENT_PAGE (doc_page);
 }
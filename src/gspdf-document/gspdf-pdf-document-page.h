@@ -20,6 +20,10 @@
 #include "gspdf-document-page.h"
 #endif
 
+#ifndef GSPDF_PDF_DOCUMENT_H
+#include "gspdf-pdf-document.h"
+#endif
+
 G_BEGIN_DECLS
 
 #define GSPDF_TYPE_PDF_DOCUMENT_PAGE gspdf_pdf_document_page_get_type ()
@@ -31,6 +35,10 @@ G_DECLARE_FINAL_TYPE (
   GspdfDocumentPage
 )
 
+GspdfDocumentPage *gspdf_pdf_document_page_new (GspdfDocument          *document,
+                                                GspdfPdfDocumentHandle *handle,
+                                                gpointer                handler);
+
 G_END_DECLS
 
 #endif
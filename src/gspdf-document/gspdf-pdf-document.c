@@ -23,8 +23,36 @@
 #include "gspdf-pdf-document-page.h"
 #endif
 
+#include "../gspdf-util/gspdf-sidecar.h"
+
+#define GSPDF_PDF_DOCUMENT_MAX_HANDLES 4
+
+// poppler is not thread safe, so each handle is an independently opened
+// copy of the file with its own lock. Pages are bound to one handle. The
+// copies are opened once, by gspdf_pdf_document_open_handles, never on
+// the thread asking for a page.
+struct _GspdfPdfDocumentHandle {
+	PopplerDocument *handler;
+	GRecMutex        mutex;
+	guint            users;
+};
+
 struct _GspdfPdfDocument {
-	GspdfDocument parent;
+	GspdfDocument           parent;
+
+	gchar                  *uri;
+	gchar                  *password;
+
+	// handles[0] borrows the "handler" property, the rest are owned
+	GMutex                  pool_mutex;
+	GspdfPdfDocumentHandle *handles[GSPDF_PDF_DOCUMENT_MAX_HANDLES];
+	guint                   n_handles;
+	guint                   max_handles;
+
+	// the file handles[0] was opened from, a copy is only kept if it
+	// was opened from the same one
+	GspdfFileId             file_id;
+	gboolean                has_file_id;
 };
 
 G_DEFINE_TYPE (
@@ -33,11 +61,82 @@ G_DEFINE_TYPE (
 	GSPDF_TYPE_DOCUMENT
 )
 
+static GspdfPdfDocumentHandle *
+_handle_new (PopplerDocument *handler)
+{
+	GspdfPdfDocumentHandle *handle = g_malloc0 (sizeof (GspdfPdfDocumentHandle));
+	handle->handler = handler;
+	g_rec_mutex_init (&handle->mutex);
+
+	return handle;
+}
+
+static void
+_handle_free (GspdfPdfDocumentHandle *handle,
+	            gboolean                owned)
+{
+	if (owned && handle->handler) {
+		g_object_unref (handle->handler);
+	}
+
+	g_rec_mutex_clear (&handle->mutex);
+	g_free (handle);
+}
+
+static void
+_lock (GspdfDocument *doc)
+{
+	gspdf_pdf_document_handle_lock (GSPDF_PDF_DOCUMENT (doc)->handles[0]);
+}
+
+static void
+_unlock (GspdfDocument *doc)
+{
+	gspdf_pdf_document_handle_unlock (GSPDF_PDF_DOCUMENT (doc)->handles[0]);
+}
+
+// picks the handle with the fewest pages bound to it
+static GspdfPdfDocumentHandle *
+_acquire_handle (GspdfPdfDocument *doc)
+{
+	g_mutex_lock (&doc->pool_mutex);
+
+	GspdfPdfDocumentHandle *ret = doc->handles[0];
+
+	for (guint i = 1; i < doc->n_handles; i++) {
+		if (doc->handles[i]->users < ret->users) {
+			ret = doc->handles[i];
+		}
+	}
+
+	ret->users++;
+
+	g_mutex_unlock (&doc->pool_mutex);
+
+	return ret;
+}
+
+// whether the file is still the one handles[0] was opened from
+static gboolean
+_is_same_file (GspdfPdfDocument *doc)
+{
+	GspdfFileId file_id;
+
+	return doc->has_file_id &&
+	       gspdf_file_id_query (doc->uri, &file_id) &&
+	       gspdf_file_id_equal (&file_id, &doc->file_id);
+}
+
 static GspdfDocument *
 gspdf_pdf_document_new_s (const char *uri,
 	                        const char *password,
 												  GError     **error)
 {
+	// taken first, a file rewritten while it is parsed then fails the
+	// check of the handles opened after it
+	GspdfFileId file_id;
+	const gboolean has_file_id = gspdf_file_id_query (uri, &file_id);
+
 	GError *perror = NULL;
 	PopplerDocument *handler = poppler_document_new_from_file (
 		uri,
@@ -77,6 +176,14 @@ gspdf_pdf_document_new_s (const char *uri,
 	}
 
 	GspdfDocument *doc = g_object_new (GSPDF_TYPE_PDF_DOCUMENT, NULL);
+	GspdfPdfDocument *pdf_doc = GSPDF_PDF_DOCUMENT (doc);
+	pdf_doc->uri = g_strdup (uri);
+	pdf_doc->password = g_strdup (password);
+	pdf_doc->handles[0] = _handle_new (handler);
+	pdf_doc->n_handles = 1;
+	pdf_doc->file_id = file_id;
+	pdf_doc->has_file_id = has_file_id;
+
 	gchar *author = poppler_document_get_author (handler);
 	gchar *creator = poppler_document_get_creator (handler);
 	gchar *keywords = poppler_document_get_keywords (handler);
@@ -168,7 +275,11 @@ gspdf_pdf_document_save (GspdfDocument *doc,
 	g_object_get (G_OBJECT (doc), "handler", &handler, NULL);
 	g_return_val_if_fail (handler != NULL, FALSE);
 
-	return poppler_document_save (handler, uri, error);
+	_lock (doc);
+	gboolean ret = poppler_document_save (handler, uri, error);
+	_unlock (doc);
+
+	return ret;
 }
 
 static gboolean
@@ -178,7 +289,32 @@ gspdf_pdf_document_linearized (GspdfDocument *doc)
 	g_object_get (G_OBJECT (doc), "handler", &handler, NULL);
 	g_return_val_if_fail (handler != NULL, FALSE);
 
-	return poppler_document_is_linearized (handler);
+	_lock (doc);
+	gboolean ret = poppler_document_is_linearized (handler);
+	_unlock (doc);
+
+	return ret;
+}
+
+// opened with a password, or restricted, which only an encrypted file
+// can be
+static gboolean
+gspdf_pdf_document_is_encrypted (GspdfDocument *doc)
+{
+	GspdfPdfDocument *pdf_doc = GSPDF_PDF_DOCUMENT (doc);
+	PopplerDocument *handler = NULL;
+	g_object_get (G_OBJECT (doc), "handler", &handler, NULL);
+	g_return_val_if_fail (handler != NULL, FALSE);
+
+	if (pdf_doc->password && (pdf_doc->password[0] != '\0')) {
+		return TRUE;
+	}
+
+	_lock (doc);
+	const PopplerPermissions permissions = poppler_document_get_permissions (handler);
+	_unlock (doc);
+
+	return (permissions & POPPLER_PERMISSIONS_FULL) != POPPLER_PERMISSIONS_FULL;
 }
 
 static gint
@@ -188,28 +324,34 @@ gspdf_pdf_document_get_n_pages (GspdfDocument *doc)
 	g_object_get (G_OBJECT (doc), "handler", &handler, NULL);
 	g_return_val_if_fail (handler != NULL, -1);
 
-	return poppler_document_get_n_pages (handler);
+	_lock (doc);
+	gint ret = poppler_document_get_n_pages (handler);
+	_unlock (doc);
+
+	return ret;
 }
 
 static GspdfDocumentPage *
 gspdf_pdf_document_get_page (GspdfDocument *doc, gint index)
 {
-	PopplerDocument *handler = NULL;
-	g_object_get (G_OBJECT (doc), "handler", &handler, NULL);
-	g_return_val_if_fail (handler != NULL, NULL);
+	GspdfPdfDocument *pdf_doc = GSPDF_PDF_DOCUMENT (doc);
+	g_return_val_if_fail (pdf_doc->n_handles > 0, NULL);
+
+	GspdfPdfDocumentHandle *handle = _acquire_handle (pdf_doc);
+
+	gspdf_pdf_document_handle_lock (handle);
+	PopplerPage *poppler_page = poppler_document_get_page (
+		handle->handler,
+		index
+	);
+	gspdf_pdf_document_handle_unlock (handle);
 
-	PopplerPage *poppler_page = poppler_document_get_page (handler, index);
 	if (!poppler_page) {
+		gspdf_pdf_document_release_handle (pdf_doc, handle);
 		return NULL;
 	}
 
-	GspdfDocumentPage *doc_page = g_object_new (
-		GSPDF_TYPE_PDF_DOCUMENT_PAGE,
-		NULL
-	);
-	g_object_set (G_OBJECT (doc_page), "handler", poppler_page, NULL);
-
-	return doc_page;
+	return gspdf_pdf_document_page_new (doc, handle, poppler_page);
 }
 
 static GspdfDocDest *
@@ -337,12 +479,17 @@ gspdf_pdf_document_get_outline (GspdfDocument *doc)
 	g_object_get (G_OBJECT (doc), "handler", &handler, NULL);
 	g_return_val_if_fail (handler != NULL, NULL);
 
+	_lock (doc);
+
 	PopplerIndexIter *poppler_index_iter = poppler_index_iter_new (handler);
-	g_return_val_if_fail (poppler_index_iter != NULL, NULL);
+	GspdfDocOutline *ret = NULL;
 
-	GspdfDocOutline *ret = _get_outline (poppler_index_iter);
+	if (poppler_index_iter) {
+		ret = _get_outline (poppler_index_iter);
+		poppler_index_iter_free (poppler_index_iter);
+	}
 
-	poppler_index_iter_free (poppler_index_iter);
+	_unlock (doc);
 
 	return ret;
 }
@@ -355,7 +502,10 @@ gspdf_pdf_document_find_dest (GspdfDocument *doc,
 	g_object_get (G_OBJECT (doc), "handler", &handler, NULL);
 	g_return_val_if_fail (handler != NULL, NULL);
 
+	_lock (doc);
 	PopplerDest *poppler_dest = poppler_document_find_dest (handler, named_dest);
+	_unlock (doc);
+
 	g_return_val_if_fail (poppler_dest != NULL, NULL);
 
 	GspdfDocDest *ret = _get_dest (poppler_dest);
@@ -365,6 +515,12 @@ gspdf_pdf_document_find_dest (GspdfDocument *doc,
 	return ret;
 }
 
+static void
+_open_handles (GspdfDocument *doc)
+{
+	gspdf_pdf_document_open_handles (GSPDF_PDF_DOCUMENT (doc));
+}
+
 static void
 gspdf_pdf_document_dispose (GObject *object)
 {
@@ -382,13 +538,28 @@ gspdf_pdf_document_dispose (GObject *object)
 static void
 gspdf_pdf_document_finalize (GObject *object)
 {
+	GspdfPdfDocument *self = GSPDF_PDF_DOCUMENT (object);
+
+	for (guint i = 0; i < self->n_handles; i++) {
+		_handle_free (self->handles[i], i > 0);
+	}
+
+	g_free (self->uri);
+	g_free (self->password);
+	g_mutex_clear (&self->pool_mutex);
+
 	G_OBJECT_CLASS (gspdf_pdf_document_parent_class)->finalize (object);
 }
 
 static void
 gspdf_pdf_document_init (GspdfPdfDocument *self)
 {
-
+	g_mutex_init (&self->pool_mutex);
+	self->max_handles = CLAMP (
+		g_get_num_processors (),
+		1,
+		GSPDF_PDF_DOCUMENT_MAX_HANDLES
+	);
 }
 
 static void
@@ -406,6 +577,8 @@ gspdf_pdf_document_class_init (GspdfPdfDocumentClass *klass)
 	parent->get_page = gspdf_pdf_document_get_page;
 	parent->get_outline = gspdf_pdf_document_get_outline;
 	parent->find_dest = gspdf_pdf_document_find_dest;
+	parent->is_encrypted = gspdf_pdf_document_is_encrypted;
+	parent->open_handles = _open_handles;
 }
 
 GspdfDocument *
@@ -415,3 +588,77 @@ gspdf_pdf_document_new (const gchar *uri,
 {
 	return gspdf_pdf_document_new_s (uri, password, error);
 }
+
+// opens the other copies of the file, parsing each takes about as long
+// as opening the document did. A copy that turns out to be of another
+// file, rewritten since, is dropped and no more are tried.
+void
+gspdf_pdf_document_open_handles (GspdfPdfDocument *doc)
+{
+	g_return_if_fail (GSPDF_IS_PDF_DOCUMENT (doc));
+
+	gspdf_pdf_document_handle_lock (doc->handles[0]);
+	const gint n_pages = poppler_document_get_n_pages (doc->handles[0]->handler);
+	gspdf_pdf_document_handle_unlock (doc->handles[0]);
+
+	g_mutex_lock (&doc->pool_mutex);
+	guint n_handles = doc->n_handles;
+	g_mutex_unlock (&doc->pool_mutex);
+
+	while (n_handles < doc->max_handles) {
+		if (!_is_same_file (doc)) {
+			break;
+		}
+
+		PopplerDocument *handler = poppler_document_new_from_file (
+			doc->uri,
+			doc->password,
+			NULL
+		);
+
+		if (!handler) {
+			break;
+		}
+
+		if ((poppler_document_get_n_pages (handler) != n_pages) ||
+		    !_is_same_file (doc)) {
+			g_object_unref (handler);
+			break;
+		}
+
+		g_mutex_lock (&doc->pool_mutex);
+		doc->handles[doc->n_handles++] = _handle_new (handler);
+		n_handles = doc->n_handles;
+		g_mutex_unlock (&doc->pool_mutex);
+	}
+}
+
+void
+gspdf_pdf_document_release_handle (GspdfPdfDocument       *doc,
+	                                 GspdfPdfDocumentHandle *handle)
+{
+	g_return_if_fail (GSPDF_IS_PDF_DOCUMENT (doc));
+	g_return_if_fail (handle != NULL);
+
+	g_mutex_lock (&doc->pool_mutex);
+	if (handle->users > 0) {
+		handle->users--;
+	}
+	g_mutex_unlock (&doc->pool_mutex);
+}
+
+void
+gspdf_pdf_document_handle_lock (GspdfPdfDocumentHandle *handle)
+{
+	g_return_if_fail (handle != NULL);
+
+	g_rec_mutex_lock (&handle->mutex);
+}
+
+void
+gspdf_pdf_document_handle_unlock (GspdfPdfDocumentHandle *handle)
+{
+	g_return_if_fail (handle != NULL);
+
+	g_rec_mutex_unlock (&handle->mutex);
+}
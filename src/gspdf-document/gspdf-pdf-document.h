@@ -35,6 +35,17 @@ GspdfDocument *gspdf_pdf_document_new (const gchar  *uri,
 									                     const gchar  *password,
 							                         GError      **error);
 
+typedef struct _GspdfPdfDocumentHandle GspdfPdfDocumentHandle;
+
+void gspdf_pdf_document_open_handles (GspdfPdfDocument *doc);
+
+void gspdf_pdf_document_release_handle (GspdfPdfDocument       *doc,
+                                        GspdfPdfDocumentHandle *handle);
+
+void gspdf_pdf_document_handle_lock (GspdfPdfDocumentHandle *handle);
+
+void gspdf_pdf_document_handle_unlock (GspdfPdfDocumentHandle *handle);
+
 G_END_DECLS
 
 #endif
@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2017, Fajar Dwi Darmanto <fajardwidarm@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include "gspdf-hit-index.h"
+
+#include <math.h>
+
+// cells per side never exceed this, a page rarely has more than a few
+// hundred lines
+#define GSPDF_HIT_INDEX_MAX_CELLS 32
+
+// a uniform grid over the page, cell i holds the rectangles
+// items[starts[i]] to items[starts[i + 1]] overlapping it
+struct _GspdfHitGrid {
+	gint            cols;
+	gint            rows;
+	gdouble         cell_width;
+	gdouble         cell_height;
+
+	guint           n_rects;
+	GspdfRectangle *rects;
+	gpointer       *data;
+
+	guint          *starts;
+	guint          *items;
+};
+
+// all in page units, independent of the scale
+struct _GspdfHitIndex {
+	GList        *links;
+	GspdfHitGrid  link_grid;
+	GspdfHitGrid  line_grid;
+};
+
+static void
+_hit_grid_get_cells (const GspdfHitGrid   *grid,
+                     const GspdfRectangle *rect,
+                     gint                 *col_start,
+                     gint                 *col_end,
+                     gint                 *row_start,
+                     gint                 *row_end)
+{
+	*col_start = CLAMP ((gint) floor (rect->x / grid->cell_width), 0, grid->cols - 1);
+	*col_end = CLAMP ((gint) floor ((rect->x + rect->width) / grid->cell_width), 0, grid->cols - 1);
+	*row_start = CLAMP ((gint) floor (rect->y / grid->cell_height), 0, grid->rows - 1);
+	*row_end = CLAMP ((gint) floor ((rect->y + rect->height) / grid->cell_height), 0, grid->rows - 1);
+}
+
+// rects and data are n long, copied. data may be NULL.
+static void
+_hit_grid_init (GspdfHitGrid         *grid,
+                gdouble               width,
+                gdouble               height,
+                const GspdfRectangle *rects,
+                gpointer             *data,
+                guint                 n)
+{
+	const gint side = CLAMP ((gint) ceil (sqrt (n)), 1, GSPDF_HIT_INDEX_MAX_CELLS);
+	const gint n_cells = side * side;
+	gint c0, c1, r0, r1;
+
+	grid->cols = side;
+	grid->rows = side;
+	grid->cell_width = MAX (width, 1) / side;
+	grid->cell_height = MAX (height, 1) / side;
+	grid->n_rects = n;
+	grid->rects = g_malloc (MAX (n, 1) * sizeof (GspdfRectangle));
+	grid->data = g_malloc (MAX (n, 1) * sizeof (gpointer));
+	grid->starts = g_malloc0 ((n_cells + 1) * sizeof (guint));
+
+	memcpy (grid->rects, rects, n * sizeof (GspdfRectangle));
+	if (data) {
+		memcpy (grid->data, data, n * sizeof (gpointer));
+	} else {
+		memset (grid->data, 0, MAX (n, 1) * sizeof (gpointer));
+	}
+
+	// count, then turn the counts into offsets and fill
+	for (guint i = 0; i < n; i++) {
+		_hit_grid_get_cells (grid, &rects[i], &c0, &c1, &r0, &r1);
+
+		for (gint row = r0; row <= r1; row++) {
+			for (gint col = c0; col <= c1; col++) {
+				grid->starts[(row * side) + col + 1]++;
+			}
+		}
+	}
+
+	for (gint i = 0; i < n_cells; i++) {
+		grid->starts[i + 1] += grid->starts[i];
+	}
+
+	guint *fill = g_malloc (n_cells * sizeof (guint));
+	memcpy (fill, grid->starts, n_cells * sizeof (guint));
+	grid->items = g_malloc (MAX (grid->starts[n_cells], 1) * sizeof (guint));
+
+	for (guint i = 0; i < n; i++) {
+		_hit_grid_get_cells (grid, &rects[i], &c0, &c1, &r0, &r1);
+
+		for (gint row = r0; row <= r1; row++) {
+			for (gint col = c0; col <= c1; col++) {
+				grid->items[fill[(row * side) + col]++] = i;
+			}
+		}
+	}
+
+	g_free (fill);
+}
+
+static void
+_hit_grid_clear (GspdfHitGrid *grid)
+{
+	g_free (grid->rects);
+	g_free (grid->data);
+	g_free (grid->starts);
+	g_free (grid->items);
+}
+
+static gboolean
+_hit_grid_lookup (const GspdfHitGrid *grid,
+                  gdouble             x,
+                  gdouble             y,
+                  gpointer           *data)
+{
+	if ((grid->n_rects == 0) || (x < 0) || (y < 0)) {
+		return FALSE;
+	}
+
+	const gint col = (gint) (x / grid->cell_width);
+	const gint row = (gint) (y / grid->cell_height);
+
+	if ((col >= grid->cols) || (row >= grid->rows)) {
+		return FALSE;
+	}
+
+	const gint cell = (row * grid->cols) + col;
+
+	for (guint i = grid->starts[cell]; i < grid->starts[cell + 1]; i++) {
+		const GspdfRectangle *rect = &grid->rects[grid->items[i]];
+
+		if ((x > rect->x) && (y > rect->y) &&
+		    (x < (rect->x + rect->width)) && (y < (rect->y + rect->height)))
+		{
+			if (data) {
+				*data = grid->data[grid->items[i]];
+			}
+
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+// takes links, a GList of GspdfDocLinkMapping, and copies the
+// GspdfRectangle of lines
+GspdfHitIndex *
+gspdf_hit_index_new (gdouble  width,
+                     gdouble  height,
+                     GList   *links,
+                     GList   *lines)
+{
+	GspdfHitIndex *ret = g_malloc0 (sizeof (GspdfHitIndex));
+	guint n = MAX (g_list_length (links), g_list_length (lines));
+	GspdfRectangle *rects = g_malloc (MAX (n, 1) * sizeof (GspdfRectangle));
+	gpointer *data = g_malloc (MAX (n, 1) * sizeof (gpointer));
+	guint i = 0;
+
+	ret->links = links;
+
+	for (GList *iter = links; iter; iter = iter->next, i++) {
+		rects[i] = ((GspdfDocLinkMapping*) iter->data)->area;
+		data[i] = iter->data;
+	}
+
+	_hit_grid_init (&ret->link_grid, width, height, rects, data, i);
+
+	i = 0;
+
+	for (GList *iter = lines; iter; iter = iter->next, i++) {
+		rects[i] = *((GspdfRectangle*) iter->data);
+		data[i] = NULL;
+	}
+
+	_hit_grid_init (&ret->line_grid, width, height, rects, data, i);
+
+	g_free (rects);
+	g_free (data);
+
+	return ret;
+}
+
+void
+gspdf_hit_index_free (GspdfHitIndex *index)
+{
+	g_return_if_fail (index != NULL);
+
+	_hit_grid_clear (&index->link_grid);
+	_hit_grid_clear (&index->line_grid);
+	g_list_free_full (index->links, (GDestroyNotify) gspdf_doc_link_mapping_free);
+	g_free (index);
+}
+
+const GspdfDocLinkMapping *
+gspdf_hit_index_get_link_at (const GspdfHitIndex *index,
+                             gdouble              x,
+                             gdouble              y)
+{
+	g_return_val_if_fail (index != NULL, NULL);
+
+	gpointer ret = NULL;
+
+	if (!_hit_grid_lookup (&index->link_grid, x, y, &ret)) {
+		return NULL;
+	}
+
+	return (const GspdfDocLinkMapping*) ret;
+}
+
+gboolean
+gspdf_hit_index_has_text_at (const GspdfHitIndex *index,
+                             gdouble              x,
+                             gdouble              y)
+{
+	g_return_val_if_fail (index != NULL, FALSE);
+
+	return _hit_grid_lookup (&index->line_grid, x, y, NULL);
+}
+
+// a grid of its own over any rectangles, rects is n long and copied
+GspdfHitGrid *
+gspdf_hit_grid_new (gdouble               width,
+                    gdouble               height,
+                    const GspdfRectangle *rects,
+                    guint                 n)
+{
+	g_return_val_if_fail ((rects != NULL) || (n == 0), NULL);
+
+	GspdfHitGrid *ret = g_malloc0 (sizeof (GspdfHitGrid));
+
+	_hit_grid_init (ret, width, height, rects, NULL, n);
+
+	return ret;
+}
+
+void
+gspdf_hit_grid_free (GspdfHitGrid *grid)
+{
+	g_return_if_fail (grid != NULL);
+
+	_hit_grid_clear (grid);
+	g_free (grid);
+}
+
+static gdouble
+_rect_distance (const GspdfRectangle *rect,
+                gdouble               x,
+                gdouble               y)
+{
+	const gdouble dx = MAX (MAX (rect->x - x, x - (rect->x + rect->width)), 0);
+	const gdouble dy = MAX (MAX (rect->y - y, y - (rect->y + rect->height)), 0);
+
+	return (dx * dx) + (dy * dy);
+}
+
+// the rectangle closest to the point, the first one on a tie, or -1 if
+// there are none. Cells are visited in rings around the point's until no
+// closer rectangle can be left.
+gint
+gspdf_hit_grid_get_nearest (const GspdfHitGrid *grid,
+                            gdouble             x,
+                            gdouble             y)
+{
+	g_return_val_if_fail (grid != NULL, -1);
+
+	if (grid->n_rects == 0) {
+		return -1;
+	}
+
+	const gint col = CLAMP ((gint) floor (x / grid->cell_width), 0, grid->cols - 1);
+	const gint row = CLAMP ((gint) floor (y / grid->cell_height), 0, grid->rows - 1);
+	const gdouble step = MIN (grid->cell_width, grid->cell_height);
+	gint ret = -1;
+	gdouble best = G_MAXDOUBLE;
+
+	for (gint ring = 0; ring < MAX (grid->cols, grid->rows); ring++) {
+		// anything in this ring is at least ring - 1 cells away
+		const gdouble bound = MAX (ring - 1, 0) * step;
+
+		if ((ret >= 0) && ((bound * bound) > best)) {
+			break;
+		}
+
+		for (gint r = row - ring; r <= row + ring; r++) {
+			if ((r < 0) || (r >= grid->rows)) {
+				continue;
+			}
+
+			for (gint c = col - ring; c <= col + ring; c++) {
+				if ((c < 0) || (c >= grid->cols) ||
+				    ((ABS (r - row) != ring) && (ABS (c - col) != ring))) {
+					continue;
+				}
+
+				const gint cell = (r * grid->cols) + c;
+
+				for (guint i = grid->starts[cell]; i < grid->starts[cell + 1]; i++) {
+					const gint item = (gint) grid->items[i];
+					const gdouble d = _rect_distance (&grid->rects[item], x, y);
+
+					if ((d < best) || ((d == best) && (item < ret))) {
+						best = d;
+						ret = item;
+					}
+				}
+			}
+		}
+	}
+
+	return ret;
+}
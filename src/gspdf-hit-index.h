@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2017, Fajar Dwi Darmanto <fajardwidarm@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef GSPDF_HIT_INDEX_H
+#define GSPDF_HIT_INDEX_H
+
+#ifndef __G_LIB_H__
+#include <glib.h>
+#endif
+
+#ifndef GSPDF_DOCUMENT_PAGE_H
+#include "gspdf-document/gspdf-document-page.h"
+#endif
+
+G_BEGIN_DECLS
+
+struct _GspdfHitIndex;
+typedef struct _GspdfHitIndex GspdfHitIndex;
+
+GspdfHitIndex *gspdf_hit_index_new (
+	gdouble width, gdouble height, GList *links, GList *lines);
+
+void gspdf_hit_index_free (GspdfHitIndex *index);
+
+const GspdfDocLinkMapping *gspdf_hit_index_get_link_at (
+	const GspdfHitIndex *index, gdouble x, gdouble y);
+
+gboolean gspdf_hit_index_has_text_at (
+	const GspdfHitIndex *index, gdouble x, gdouble y);
+
+struct _GspdfHitGrid;
+typedef struct _GspdfHitGrid GspdfHitGrid;
+
+GspdfHitGrid *gspdf_hit_grid_new (
+	gdouble width, gdouble height, const GspdfRectangle *rects, guint n);
+
+void gspdf_hit_grid_free (GspdfHitGrid *grid);
+
+gint gspdf_hit_grid_get_nearest (
+	const GspdfHitGrid *grid, gdouble x, gdouble y);
+
+G_END_DECLS
+
+#endif
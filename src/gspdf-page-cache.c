@@ -15,6 +15,69 @@
 
 #include "gspdf-page-cache.h"
 
+#include "gspdf-util/gspdf-buffer-pool.h"
+
+#include <math.h>
+
+// added to every render of a cache whose tab is not focused, so its
+// pages only run when no focused tab has anything queued, prefetch included
+#define GSPDF_PAGE_CACHE_BACKGROUND_PRIORITY 1000
+
+// shared by every cache of the process, the caches of tabs in the
+// background hold at most half of it between them
+#define GSPDF_PAGE_CACHE_DEFAULT_BUDGET (256 * 1024 * 1024)
+
+// pages rendered ahead of the scroll direction, grows with the velocity
+// so that roughly GSPDF_PAGE_CACHE_PREFETCH_TIME seconds are covered
+#define GSPDF_PAGE_CACHE_PREFETCH_MIN  2
+#define GSPDF_PAGE_CACHE_PREFETCH_MAX  16
+#define GSPDF_PAGE_CACHE_PREFETCH_TIME 0.5
+
+// pages bigger than this many pixels are rendered as square tiles, only
+// those around the viewport are kept
+#define GSPDF_PAGE_CACHE_TILE_THRESHOLD (2048 * 2048)
+#define GSPDF_PAGE_CACHE_TILE_SIZE      512
+#define GSPDF_PAGE_CACHE_WHOLE_PAGE     -1
+
+// text mappings are kept for pages up to this far from the visible range
+#define GSPDF_PAGE_CACHE_TEXT_KEEP 32
+
+// a search is split in tasks of this many pages so that several workers
+// share it, the chunks nearest to the start page go first, before
+// prefetching but after the visible pages
+#define GSPDF_PAGE_CACHE_FIND_CHUNK    16
+#define GSPDF_PAGE_CACHE_FIND_PRIORITY (GSPDF_TASK_PRIORITY_DEFAULT + 100)
+
+// the text index is built after everything else the focused tab wants
+// but before the renders of the other tabs
+#define GSPDF_PAGE_CACHE_INDEX_PRIORITY (GSPDF_PAGE_CACHE_BACKGROUND_PRIORITY - 1)
+
+typedef struct {
+	gint    index;
+	gdouble scale;
+	gint    tile;
+} GspdfPageCacheKey;
+
+typedef struct {
+	GspdfPageCacheKey  key;
+	GspdfTask         *task;
+	gsize              bytes;
+	GList              link;
+
+	// pixels of the page covered by a tile
+	GspdfRectangle     rect;
+
+	// the render was copied to a surface similar to the window
+	gboolean           uploaded;
+} GspdfPageCacheEntry;
+
+typedef struct {
+	gint   index;
+	GList *rects;
+	// how many hits the results before this one have
+	gint   match;
+} GspdfPageCacheFindResult;
+
 typedef struct {
 	gchar              *uri;
 	gchar              *password;
@@ -24,10 +87,57 @@ typedef struct {
 	gint                start;
 	gint                end;
 	gdouble             scale;
+	gboolean            active;
+	gboolean            continuous;
+
+	// the visible range plus the pages rendered speculatively around it
+	gint                prefetch_start;
+	gint                prefetch_end;
+	gint                direction;
+	gdouble             velocity;
+	gint64              last_time;
 
 	GspdfTaskScheduler *task_scheduler;
 	GspdfTask 		     *task_loader;
-	GSList             *task_renders;
+	GPtrArray          *doc_map;
+
+	// the words of every page, built once the document is fully loaded,
+	// searches only go through the pages it points to
+	GspdfTask          *task_index;
+
+	// (index, scale) -> GspdfPageCacheEntry, every entry is also in lru,
+	// most recently shown first
+	GHashTable         *task_renders;
+	// page index -> GSList of its entries, one per scale
+	GHashTable         *task_renders_by_index;
+	GQueue              lru;
+	gsize               bytes;
+
+	// page index -> GspdfTaskText, the mapping does not depend on the
+	// scale so one per page is enough
+	GHashTable         *task_texts;
+
+	// indices of pages finished since the last notification, filled from
+	// the workers and flushed by a single idle
+	GMutex              finished_mutex;
+	GArray             *finished;
+	guint               finished_idle;
+
+	// finished renders are uploaded to surfaces similar to this one
+	// before they are drawn, weak
+	GdkWindow          *window;
+
+	// the chunks of the running search in search order, results are
+	// taken from find_next on only, so they come sorted from the start
+	// page even though the chunks run in parallel
+	GPtrArray          *find_tasks;
+	guint               find_next;
+	gboolean            find_running;
+	GPtrArray          *find_results;
+	gint                find_n_matches;
+	gint                find_generation;
+	GMutex              find_mutex;
+	guint               find_idle;
 } GspdfPageCachePrivate;
 
 struct _GspdfPageCache {
@@ -39,11 +149,38 @@ G_DEFINE_TYPE_WITH_PRIVATE (GspdfPageCache, gspdf_page_cache, G_TYPE_OBJECT)
 enum {
 	SIGNAL_DOCUMENT_LOAD_FINISHED = 0,
 	SIGNAL_DOCUMENT_RENDER_FINISHED,
+	SIGNAL_DOCUMENT_MAP_CHANGED,
+	SIGNAL_FIND_RESULT,
+	SIGNAL_FIND_FINISHED,
 	N_SIGNALS
 };
 
 static guint obj_signals[N_SIGNALS] = {0};
 
+static GType obj_signal_document_render_finished_params[1];
+
+static GType obj_signal_document_map_changed_params[2];
+
+static GType obj_signal_find_result_params[1];
+
+// the GspdfPageCachePrivate of every cache, touched on the main thread only
+static GList *gspdf_page_cache_instances = NULL;
+
+static gsize gspdf_page_cache_budget = GSPDF_PAGE_CACHE_DEFAULT_BUDGET;
+
+// a trim queued by an upload growing a cache, 0 if none
+static guint gspdf_page_cache_evict_source = 0;
+
+static gboolean gspdf_page_cache_evict_all_idle (gpointer user_data);
+
+static GHashTable *gspdf_page_cache_task_renders_new (void);
+
+static void gspdf_page_cache_task_renders_clear (GspdfPageCachePrivate *priv);
+
+static void _task_cancel_free_func (gpointer data);
+
+// runs for the loader's progress and when it finishes: publishes the
+// document as soon as the loader has one, then applies measured sizes
 static gboolean
 task_loader_finished (gpointer user_data)
 {
@@ -52,22 +189,70 @@ task_loader_finished (gpointer user_data)
 		page_cache
 	);
 
-	priv->document = gspdf_task_loader_get_document (
-		GSPDF_TASK_LOADER (priv->task_loader)
-	);
+	// a callback already running when the cache was disposed queued this
+	if (!priv->task_loader) {
+		return FALSE;
+	}
+
+	GspdfTaskLoader *task_loader = GSPDF_TASK_LOADER (priv->task_loader);
+
+	if (!priv->doc_map) {
+		priv->doc_map = gspdf_task_loader_get_document_map (task_loader);
+
+		if (priv->doc_map) {
+			priv->document = gspdf_task_loader_get_document (task_loader);
+		} else {
+			// nothing published yet, unless the document failed to open
+			GError *error = gspdf_task_loader_get_gerror (task_loader);
+
+			if (!error) {
+				return FALSE;
+			}
+
+			g_error_free (error);
+		}
 
-	if (priv->document) {
 		g_signal_emit (
 			G_OBJECT (page_cache),
 			obj_signals[SIGNAL_DOCUMENT_LOAD_FINISHED],
 			0
 		);
 	}
-	else {
+
+	gint start = -1, end = -1;
+
+	if (priv->doc_map &&
+	    gspdf_task_loader_update_document_map (task_loader, &start, &end))
+	{
 		g_signal_emit (
 			G_OBJECT (page_cache),
-			obj_signals[SIGNAL_DOCUMENT_LOAD_FINISHED],
-			0
+			obj_signals[SIGNAL_DOCUMENT_MAP_CHANGED],
+			0,
+			start,
+			end
+		);
+	}
+
+	// indexing waits for the loader, both read every page. The index is
+	// kept on disk in the clear, a protected document is only ever
+	// scanned.
+	if (priv->document && !priv->task_index &&
+	    !priv->password && !gspdf_document_is_encrypted (priv->document) &&
+	    (gspdf_task_get_status (priv->task_loader) == GSPDF_TASK_STATUS_OK))
+	{
+		priv->task_index = gspdf_task_index_new ();
+
+		gspdf_task_index_set (
+			GSPDF_TASK_INDEX (priv->task_index),
+			priv->document,
+			priv->uri
+		);
+
+		gspdf_task_scheduler_push (
+			priv->task_scheduler,
+			priv->task_index,
+			GSPDF_PAGE_CACHE_INDEX_PRIORITY +
+				((priv->active) ? 0 : GSPDF_PAGE_CACHE_BACKGROUND_PRIORITY)
 		);
 	}
 
@@ -78,13 +263,24 @@ static gboolean
 task_render_finished (gpointer user_data)
 {
 	GspdfPageCache *page_cache = (GspdfPageCache*) user_data;
-	//GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (page_cache);
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (page_cache);
 
-	g_signal_emit (
+	g_mutex_lock (&priv->finished_mutex);
+	GArray *finished = priv->finished;
+	priv->finished = g_array_new (FALSE, FALSE, sizeof (gint));
+	priv->finished_idle = 0;
+	g_mutex_unlock (&priv->finished_mutex);
+
+	if ((finished->len > 0) && priv->task_renders) {
+		g_signal_emit (
 			G_OBJECT (page_cache),
 			obj_signals[SIGNAL_DOCUMENT_RENDER_FINISHED],
-			0
+			0,
+			finished
 		);
+	}
+
+	g_array_unref (finished);
 
 	return FALSE;
 }
@@ -94,32 +290,288 @@ task_loader_finished_cb (GspdfTask *task,
 						             gpointer   user_data)
 {
 	if (gspdf_task_get_status (task) == GSPDF_TASK_STATUS_OK) {
-		g_idle_add (task_loader_finished, user_data);
+		g_idle_add_full (
+			G_PRIORITY_DEFAULT_IDLE,
+			task_loader_finished,
+			g_object_ref (user_data),
+			g_object_unref
+		);
 	}
 }
 
+static void
+task_loader_progress_cb (GspdfTask *task,
+	                       gpointer   user_data)
+{
+	g_idle_add_full (
+		G_PRIORITY_DEFAULT_IDLE,
+		task_loader_finished,
+		g_object_ref (user_data),
+		g_object_unref
+	);
+}
+
 static void
 task_render_finished_cb (GspdfTask *task,
 						             gpointer   user_data)
 {
-	if (gspdf_task_get_status (task) == GSPDF_TASK_STATUS_OK) {
-		g_idle_add (task_render_finished, user_data);
+	if (gspdf_task_get_status (task) != GSPDF_TASK_STATUS_OK) {
+		return;
+	}
+
+	GspdfPageCache *page_cache = (GspdfPageCache*) user_data;
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (page_cache);
+	gint index = gspdf_task_render_get_index (GSPDF_TASK_RENDER (task));
+
+	g_mutex_lock (&priv->finished_mutex);
+
+	gboolean found = FALSE;
+
+	for (guint i = 0; i < priv->finished->len; i++) {
+		if (g_array_index (priv->finished, gint, i) == index) {
+			found = TRUE;
+			break;
+		}
+	}
+
+	if (!found) {
+		g_array_append_val (priv->finished, index);
+	}
+
+	// pages finishing together are reported by the same idle
+	if (priv->finished_idle == 0) {
+		priv->finished_idle = g_idle_add_full (
+			G_PRIORITY_DEFAULT_IDLE,
+			task_render_finished,
+			g_object_ref (page_cache),
+			g_object_unref
+		);
+	}
+
+	g_mutex_unlock (&priv->finished_mutex);
+}
+
+// hands the results of the chunks over in search order, the search is
+// finished once the last chunk is
+static gboolean
+task_find_flush (gpointer user_data)
+{
+	GspdfPageCache *page_cache = (GspdfPageCache*) user_data;
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (page_cache);
+
+	g_mutex_lock (&priv->find_mutex);
+	priv->find_idle = 0;
+	g_mutex_unlock (&priv->find_mutex);
+
+	if (!priv->find_tasks || !priv->find_running) {
+		return FALSE;
+	}
+
+	const gint generation = priv->find_generation;
+	GList *rects = NULL;
+	gint index = -1;
+
+	while (priv->find_next < priv->find_tasks->len) {
+		GspdfTask *task = g_ptr_array_index (priv->find_tasks, priv->find_next);
+
+		// read before draining, a chunk queues all its results before
+		// it is marked finished
+		const gboolean done = gspdf_task_get_status (task) == GSPDF_TASK_STATUS_OK;
+
+		while ((rects = gspdf_task_find_pop_result (GSPDF_TASK_FIND (task), &index)) != NULL) {
+			GspdfPageCacheFindResult *result = g_malloc (sizeof (GspdfPageCacheFindResult));
+			result->index = index;
+			result->rects = rects;
+			result->match = priv->find_n_matches;
+			priv->find_n_matches += g_list_length (rects);
+			g_ptr_array_add (priv->find_results, result);
+
+			g_signal_emit (
+				G_OBJECT (page_cache),
+				obj_signals[SIGNAL_FIND_RESULT],
+				0,
+				(gint) priv->find_results->len - 1
+			);
+
+			// a handler started another search or cancelled this one
+			if (priv->find_generation != generation) {
+				return FALSE;
+			}
+		}
+
+		if (!done) {
+			return FALSE;
+		}
+
+		priv->find_next++;
+	}
+
+	priv->find_running = FALSE;
+
+	g_signal_emit (
+		G_OBJECT (page_cache),
+		obj_signals[SIGNAL_FIND_FINISHED],
+		0
+	);
+
+	return FALSE;
+}
+
+static void
+task_find_progress_cb (GspdfTask *task,
+	                     gpointer   user_data)
+{
+	GspdfPageCache *page_cache = (GspdfPageCache*) user_data;
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (page_cache);
+
+	g_mutex_lock (&priv->find_mutex);
+
+	if (priv->find_idle == 0) {
+		priv->find_idle = g_idle_add_full (
+			G_PRIORITY_DEFAULT_IDLE,
+			task_find_flush,
+			g_object_ref (page_cache),
+			g_object_unref
+		);
 	}
+
+	g_mutex_unlock (&priv->find_mutex);
+}
+
+static void
+_find_result_free_func (gpointer data)
+{
+	GspdfPageCacheFindResult *result = (GspdfPageCacheFindResult*) data;
+
+	g_list_free_full (result->rects, g_free);
+	g_free (result);
 }
 
 static void
 gspdf_page_cache_init (GspdfPageCache *self)
 {
 	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (self);
-	priv->task_scheduler = gspdf_task_scheduler_new ();
+	priv->task_scheduler = gspdf_task_scheduler_get_default ();
 	priv->task_loader = gspdf_task_loader_new ();
 	priv->scale = 1.0;
+	priv->active = TRUE;
+	priv->continuous = TRUE;
+	priv->direction = 1;
+	priv->task_renders = gspdf_page_cache_task_renders_new ();
+	priv->task_renders_by_index = g_hash_table_new (g_direct_hash, g_direct_equal);
+	priv->task_texts = g_hash_table_new_full (
+		g_direct_hash,
+		g_direct_equal,
+		NULL,
+		_task_cancel_free_func
+	);
+	gspdf_page_cache_instances = g_list_prepend (gspdf_page_cache_instances, priv);
+	g_queue_init (&priv->lru);
+	priv->finished = g_array_new (FALSE, FALSE, sizeof (gint));
+	g_mutex_init (&priv->finished_mutex);
+	priv->find_tasks = g_ptr_array_new_with_free_func (_task_cancel_free_func);
+	priv->find_results = g_ptr_array_new_with_free_func (_find_result_free_func);
+	g_mutex_init (&priv->find_mutex);
 
 	gspdf_task_set_finished_callback (
 		priv->task_loader,
 		task_loader_finished_cb,
 		self
 	);
+
+	// called once the document is published and then periodically while
+	// page sizes are measured
+	gspdf_task_set_progress_callback (
+		priv->task_loader,
+		task_loader_progress_cb,
+		self
+	);
+}
+
+static void
+gspdf_page_cache_dispose (GObject *object)
+{
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		GSPDF_PAGE_CACHE (object)
+	);
+
+	if (g_list_find (gspdf_page_cache_instances, priv)) {
+		gspdf_page_cache_instances = g_list_remove (gspdf_page_cache_instances, priv);
+	}
+
+	if (priv->task_renders) {
+		gspdf_page_cache_task_renders_clear (priv);
+		g_hash_table_unref (priv->task_renders);
+		g_hash_table_unref (priv->task_renders_by_index);
+		priv->task_renders = NULL;
+		priv->task_renders_by_index = NULL;
+
+		// buffers sized for this document's pages are unlikely to fit the next
+		gspdf_buffer_pool_trim (gspdf_buffer_pool_get_default ());
+	}
+
+	if (priv->task_texts) {
+		g_hash_table_unref (priv->task_texts);
+		priv->task_texts = NULL;
+	}
+
+	if (priv->task_index) {
+		_task_cancel_free_func (priv->task_index);
+		priv->task_index = NULL;
+	}
+
+	if (priv->find_tasks) {
+		g_ptr_array_unref (priv->find_tasks);
+		g_ptr_array_unref (priv->find_results);
+		priv->find_tasks = NULL;
+		priv->find_results = NULL;
+	}
+
+	if (priv->doc_map) {
+		g_ptr_array_unref (priv->doc_map);
+		priv->doc_map = NULL;
+	}
+
+	if (priv->task_loader) {
+		gspdf_task_set_finished_callback (priv->task_loader, NULL, NULL);
+		gspdf_task_set_progress_callback (priv->task_loader, NULL, NULL);
+		gspdf_task_cancel (priv->task_loader);
+		g_object_unref (priv->task_loader);
+		priv->task_loader = NULL;
+	}
+
+	if (priv->document) {
+		g_object_unref (priv->document);
+		priv->document = NULL;
+	}
+
+	if (priv->error) {
+		g_error_free (priv->error);
+		priv->error = NULL;
+	}
+
+	if (priv->window) {
+		g_object_remove_weak_pointer (G_OBJECT (priv->window), (gpointer*) &priv->window);
+		priv->window = NULL;
+	}
+
+	G_OBJECT_CLASS (gspdf_page_cache_parent_class)->dispose (object);
+}
+
+static void
+gspdf_page_cache_finalize (GObject *object)
+{
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		GSPDF_PAGE_CACHE (object)
+	);
+
+	g_free (priv->uri);
+	g_free (priv->password);
+	g_array_unref (priv->finished);
+	g_mutex_clear (&priv->finished_mutex);
+	g_mutex_clear (&priv->find_mutex);
+
+	G_OBJECT_CLASS (gspdf_page_cache_parent_class)->finalize (object);
 }
 
 static void
@@ -127,7 +579,11 @@ gspdf_page_cache_class_init (GspdfPageCacheClass *klass)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
-	//obj_signal_document_render_finished_params[0] = G_TYPE_INT;
+	object_class->dispose = gspdf_page_cache_dispose;
+	object_class->finalize = gspdf_page_cache_finalize;
+
+	// a GArray of gint, the indices of the pages rendered since last time
+	obj_signal_document_render_finished_params[0] = G_TYPE_POINTER;
 
 	obj_signals[SIGNAL_DOCUMENT_LOAD_FINISHED] =  g_signal_newv (
 		"document-load-finished",
@@ -139,141 +595,1145 @@ gspdf_page_cache_class_init (GspdfPageCacheClass *klass)
 		  //1, obj_signal_document_load_finished_params
 	);
 
+	// the first and last index of the pages whose size changed once
+	// measured, the document is first shown with estimated sizes
+	obj_signal_document_map_changed_params[0] = G_TYPE_INT;
+	obj_signal_document_map_changed_params[1] = G_TYPE_INT;
+
+	obj_signals[SIGNAL_DOCUMENT_MAP_CHANGED] =  g_signal_newv (
+		"document-map-changed",
+		 G_TYPE_FROM_CLASS (object_class),
+		  G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+		  NULL, NULL, NULL, NULL,
+		  G_TYPE_NONE,
+		  2, obj_signal_document_map_changed_params
+	);
+
+	// the position of the new result, see gspdf_page_cache_get_find_result
+	obj_signal_find_result_params[0] = G_TYPE_INT;
+
+	obj_signals[SIGNAL_FIND_RESULT] =  g_signal_newv (
+		"find-result",
+		 G_TYPE_FROM_CLASS (object_class),
+		  G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+		  NULL, NULL, NULL, NULL,
+		  G_TYPE_NONE,
+		  1, obj_signal_find_result_params
+	);
+
+	obj_signals[SIGNAL_FIND_FINISHED] =  g_signal_newv (
+		"find-finished",
+		 G_TYPE_FROM_CLASS (object_class),
+		  G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+		  NULL, NULL, NULL, NULL,
+		  G_TYPE_NONE,
+		  0, NULL
+	);
+
 	obj_signals[SIGNAL_DOCUMENT_RENDER_FINISHED] =  g_signal_newv (
 		"document-render-finished",
 		 G_TYPE_FROM_CLASS (object_class),
 		  G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
 		  NULL, NULL, NULL, NULL,
 		  G_TYPE_NONE,
-		  0, NULL
-		  //1, obj_signal_document_render_finished_params
+		  1, obj_signal_document_render_finished_params
 	);
 }
 
-static void
-_task_renders_list_free_func (gpointer data)
+// pages closer to the middle of the visible range render first,
+// prefetched pages only after all of them, nearest first
+static gint
+_get_render_priority (GspdfPageCachePrivate *priv,
+	                    gint                   index)
 {
-	GspdfTaskRender *task = (GspdfTaskRender*) data;
-	g_object_unref (task);
+	gint ret = GSPDF_TASK_PRIORITY_DEFAULT;
+
+	if (index < priv->start) {
+		ret = GSPDF_TASK_PRIORITY_LOW + (priv->start - index);
+	} else if (index > priv->end) {
+		ret = GSPDF_TASK_PRIORITY_LOW + (index - priv->end);
+	} else {
+		ret += ABS (2 * index - (priv->start + priv->end));
+	}
+
+	if (!priv->active) {
+		ret += GSPDF_PAGE_CACHE_BACKGROUND_PRIORITY;
+	}
+
+	return ret;
 }
 
-static void
-gspdf_page_cache_task_renders_clear (GSList *list)
+static guint
+_task_renders_key_hash (gconstpointer data)
 {
-	g_slist_free_full (list, _task_renders_list_free_func);
+	const GspdfPageCacheKey *key = (const GspdfPageCacheKey*) data;
+
+	return ((guint) key->index * 31) ^ ((guint) key->tile * 131) ^
+	       g_double_hash (&key->scale);
 }
 
-GspdfPageCache *
-gspdf_page_cache_new ()
+static gboolean
+_task_renders_key_equal (gconstpointer a,
+	                       gconstpointer b)
 {
-	return g_object_new (GSPDF_TYPE_PAGE_CACHE, NULL);
+	const GspdfPageCacheKey *ka = (const GspdfPageCacheKey*) a;
+	const GspdfPageCacheKey *kb = (const GspdfPageCacheKey*) b;
+
+	return (ka->index == kb->index) &&
+	       (ka->tile == kb->tile) &&
+	       (ka->scale == kb->scale);
 }
 
-void
-gspdf_page_cache_open_document (GspdfPageCache *page_cache,
-								                const gchar    *uri,
-								                const gchar    *password)
+static void
+_task_renders_entry_free_func (gpointer data)
 {
-	g_return_if_fail (page_cache != NULL);
-	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
-	g_return_if_fail (uri != NULL);
+	GspdfPageCacheEntry *entry = (GspdfPageCacheEntry*) data;
 
-	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
-		page_cache
-	);
+	// the scheduler may still hold the task after the cache is gone
+	gspdf_task_set_finished_callback (entry->task, NULL, NULL);
 
-	if (priv->document) {
-		g_object_unref (priv->document);
-		priv->document = NULL;
+	switch (gspdf_task_get_status (entry->task)) {
+		case GSPDF_TASK_STATUS_IDLE:
+		case GSPDF_TASK_STATUS_RUNNING:
+			gspdf_task_cancel (entry->task);
+			break;
+		default:
+			break;
 	}
 
-	if (priv->error) {
-		g_error_free (priv->error);
-		priv->error = NULL;
-	}
+	g_object_unref (entry->task);
+	g_free (entry);
+}
 
-	if (priv->uri) {
-		g_free (priv->uri);
-		priv->uri = NULL;
-	}
+// (index, scale) -> GspdfPageCacheEntry, dropping an entry cancels its
+// render if it has not finished yet
+static GHashTable *
+gspdf_page_cache_task_renders_new (void)
+{
+	return g_hash_table_new_full (
+		_task_renders_key_hash,
+		_task_renders_key_equal,
+		NULL,
+		_task_renders_entry_free_func
+	);
+}
 
-	if (priv->password) {
-		g_free (priv->password);
-		priv->password = NULL;
-	}
+static GspdfPageCacheEntry *
+gspdf_page_cache_task_renders_lookup (GHashTable *table,
+	                                    gint        index,
+	                                    gdouble     scale,
+	                                    gint        tile)
+{
+	const GspdfPageCacheKey key = { index, scale, tile };
 
-	if (priv->task_renders) {
-		GSList *iter = priv->task_renders;
+	return (GspdfPageCacheEntry*) g_hash_table_lookup (table, &key);
+}
 
-		while (iter != NULL) {
-			if (iter->data != NULL) {
-				g_object_unref (G_OBJECT (iter->data));
-				iter->data = NULL;
-			}
+static void
+gspdf_page_cache_task_renders_add (GspdfPageCachePrivate *priv,
+	                                 GspdfPageCacheEntry   *entry)
+{
+	gpointer index = GINT_TO_POINTER (entry->key.index);
+	GSList *list = g_hash_table_lookup (priv->task_renders_by_index, index);
+
+	g_hash_table_insert (priv->task_renders, &entry->key, entry);
+	g_hash_table_insert (
+		priv->task_renders_by_index,
+		index,
+		g_slist_prepend (list, entry)
+	);
+	g_queue_push_head_link (&priv->lru, &entry->link);
+	priv->bytes += entry->bytes;
+}
 
-			iter = iter->next;
-		}
+static void
+gspdf_page_cache_task_renders_remove (GspdfPageCachePrivate *priv,
+	                                    GspdfPageCacheEntry   *entry)
+{
+	gpointer index = GINT_TO_POINTER (entry->key.index);
+	GSList *list = g_hash_table_lookup (priv->task_renders_by_index, index);
 
-		g_slist_free (priv->task_renders);
-		priv->task_renders = NULL;
+	list = g_slist_remove (list, entry);
+
+	if (list) {
+		g_hash_table_insert (priv->task_renders_by_index, index, list);
+	} else {
+		g_hash_table_remove (priv->task_renders_by_index, index);
 	}
 
-	priv->uri = g_strdup (uri);
-	priv->password = g_strdup (password);
-	priv->start = 0;
-	priv->end = 0;
-	priv->scale = 1.0;
+	g_queue_unlink (&priv->lru, &entry->link);
+	priv->bytes -= entry->bytes;
+	g_hash_table_remove (priv->task_renders, &entry->key);
+}
 
-	gspdf_task_loader_set (
-		GSPDF_TASK_LOADER (priv->task_loader),
-		priv->uri,
-		priv->password
+static void
+_task_renders_by_index_free_func (gpointer key,
+	                                gpointer value,
+	                                gpointer user_data)
+{
+	g_slist_free ((GSList*) value);
+}
+
+static void
+gspdf_page_cache_task_renders_clear (GspdfPageCachePrivate *priv)
+{
+	g_hash_table_foreach (
+		priv->task_renders_by_index,
+		_task_renders_by_index_free_func,
+		NULL
+	);
+	g_hash_table_remove_all (priv->task_renders_by_index);
+	g_hash_table_remove_all (priv->task_renders);
+	g_queue_init (&priv->lru);
+	priv->bytes = 0;
+}
+
+// rough size of the image a page renders to, 4 bytes per pixel
+static gsize
+_get_render_bytes (GspdfPageCachePrivate *priv,
+	                 gint                   index,
+	                 gdouble                scale)
+{
+	if (!priv->doc_map || (index < 0) || ((guint) index >= priv->doc_map->len)) {
+		return 0;
+	}
+
+	GspdfDocMap *map = (GspdfDocMap*) g_ptr_array_index (priv->doc_map, index);
+
+	return (gsize) ceil (map->width * scale) * (gsize) ceil (map->height * scale) * 4;
+}
+
+// size in pixels of the page rendered at scale
+static gboolean
+_get_page_size (GspdfPageCachePrivate *priv,
+	              gint                   index,
+	              gdouble                scale,
+	              gdouble               *width,
+	              gdouble               *height)
+{
+	if (!priv->doc_map || (index < 0) || ((guint) index >= priv->doc_map->len)) {
+		return FALSE;
+	}
+
+	GspdfDocMap *map = (GspdfDocMap*) g_ptr_array_index (priv->doc_map, index);
+
+	*width = ceil (map->width * scale);
+	*height = ceil (map->height * scale);
+
+	return TRUE;
+}
+
+static gboolean
+_is_tiled (GspdfPageCachePrivate *priv,
+	         gint                   index,
+	         gdouble                scale)
+{
+	gdouble width = 0, height = 0;
+
+	if (!_get_page_size (priv, index, scale, &width, &height)) {
+		return FALSE;
+	}
+
+	return (width * height) > GSPDF_PAGE_CACHE_TILE_THRESHOLD;
+}
+
+static GspdfPageCacheEntry *
+_queue_render (GspdfPageCache       *page_cache,
+	             gint                  index,
+	             gint                  tile,
+	             const GspdfRectangle *rect,
+	             gint                  priority)
+{
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	GspdfTask *task = gspdf_task_render_new ();
+
+	gspdf_task_render_set (
+		GSPDF_TASK_RENDER (task),
+		priv->document,
+		index,
+		priv->scale
+	);
+
+	gspdf_task_render_set_region (GSPDF_TASK_RENDER (task), rect);
+
+	gspdf_task_set_finished_callback (
+		task,
+		task_render_finished_cb,
+		page_cache
+	);
+
+	GspdfPageCacheEntry *entry = g_malloc0 (sizeof (GspdfPageCacheEntry));
+	entry->key.index = index;
+	entry->key.scale = priv->scale;
+	entry->key.tile = tile;
+	entry->task = task;
+	entry->link.data = entry;
+
+	if (rect) {
+		entry->rect = *rect;
+		entry->bytes = (gsize) (ceil (rect->width) * ceil (rect->height) * 4);
+	} else {
+		entry->bytes = _get_render_bytes (priv, index, priv->scale);
+	}
+
+	gspdf_page_cache_task_renders_add (priv, entry);
+
+	gspdf_task_scheduler_push (priv->task_scheduler, task, priority);
+
+	return entry;
+}
+
+// text is only needed once the page's pixels are up. Visible pages get
+// theirs right after their render, before the renders further out, so
+// that their links work early.
+static gint
+_get_text_priority (GspdfPageCachePrivate *priv,
+	                  gint                   index)
+{
+	if ((index >= priv->start) && (index <= priv->end)) {
+		return _get_render_priority (priv, index) + 1;
+	}
+
+	return _get_render_priority (priv, index) + GSPDF_TASK_PRIORITY_LOW;
+}
+
+static void
+_task_cancel_free_func (gpointer data)
+{
+	GspdfTask *task = (GspdfTask*) data;
+
+	gspdf_task_set_finished_callback (task, NULL, NULL);
+	gspdf_task_set_progress_callback (task, NULL, NULL);
+
+	switch (gspdf_task_get_status (task)) {
+		case GSPDF_TASK_STATUS_IDLE:
+		case GSPDF_TASK_STATUS_RUNNING:
+			gspdf_task_cancel (task);
+			break;
+		default:
+			break;
+	}
+
+	g_object_unref (task);
+}
+
+static void
+_queue_text (GspdfPageCachePrivate *priv,
+	           gint                   index)
+{
+	GspdfTask *task = g_hash_table_lookup (priv->task_texts, GINT_TO_POINTER (index));
+
+	if (task) {
+		gspdf_task_set_priority (task, _get_text_priority (priv, index));
+		return;
+	}
+
+	task = gspdf_task_text_new ();
+	gspdf_task_text_set (GSPDF_TASK_TEXT (task), priv->document, index);
+	g_hash_table_insert (priv->task_texts, GINT_TO_POINTER (index), task);
+
+	gspdf_task_scheduler_push (
+		priv->task_scheduler,
+		task,
+		_get_text_priority (priv, index)
+	);
+}
+
+// unfinished mappings of pages that left the prefetch range are dropped,
+// finished ones once they are far enough from the visible range
+static gboolean
+_task_texts_is_stale (gpointer key,
+	                    gpointer value,
+	                    gpointer user_data)
+{
+	GspdfPageCachePrivate *priv = (GspdfPageCachePrivate*) user_data;
+	const gint index = GPOINTER_TO_INT (key);
+
+	if ((index >= priv->prefetch_start) && (index <= priv->prefetch_end)) {
+		return FALSE;
+	}
+
+	if (gspdf_task_get_status ((GspdfTask*) value) != GSPDF_TASK_STATUS_OK) {
+		return TRUE;
+	}
+
+	return (index < priv->start - GSPDF_PAGE_CACHE_TEXT_KEEP) ||
+	       (index > priv->end + GSPDF_PAGE_CACHE_TEXT_KEEP);
+}
+
+// replaces the client side image of a finished render by a copy in a
+// surface similar to the window, so that redraws composite from the
+// display server's copy instead of uploading the pixels every frame.
+// The image's buffer goes back to the pool.
+static void
+_upload (GspdfPageCachePrivate *priv,
+	       GspdfPageCacheEntry   *entry)
+{
+	if (entry->uploaded || !priv->window) {
+		return;
+	}
+
+	if (gspdf_task_get_status (entry->task) != GSPDF_TASK_STATUS_OK) {
+		return;
+	}
+
+	cairo_surface_t *image = gspdf_task_render_get_surface (
+		GSPDF_TASK_RENDER (entry->task)
+	);
+
+	if (!image) {
+		return;
+	}
+
+	cairo_surface_t *surface = gdk_window_create_similar_surface (
+		priv->window,
+		CAIRO_CONTENT_COLOR,
+		cairo_image_surface_get_width (image),
+		cairo_image_surface_get_height (image)
+	);
+
+	cairo_t *cr = cairo_create (surface);
+	cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_surface (cr, image, 0, 0);
+	cairo_paint (cr);
+	cairo_destroy (cr);
+
+	// on HiDPI the copy has the window's scale factor on each side
+	gdouble x_scale = 1, y_scale = 1;
+	cairo_surface_get_device_scale (surface, &x_scale, &y_scale);
+
+	priv->bytes -= entry->bytes;
+	entry->bytes = (gsize) (
+		ceil (cairo_image_surface_get_width (image) * x_scale) *
+		ceil (cairo_image_surface_get_height (image) * y_scale) * 4
+	);
+	priv->bytes += entry->bytes;
+
+	// the caller is still walking the entries, trim once it is done
+	if (!gspdf_page_cache_evict_source) {
+		gspdf_page_cache_evict_source = g_idle_add (
+			gspdf_page_cache_evict_all_idle,
+			NULL
+		);
+	}
+
+	gspdf_task_render_set_surface (GSPDF_TASK_RENDER (entry->task), surface);
+	entry->uploaded = TRUE;
+
+	cairo_surface_destroy (surface);
+	cairo_surface_destroy (image);
+}
+
+static gboolean
+_is_wanted (GspdfPageCachePrivate *priv,
+	          GspdfPageCacheEntry   *entry)
+{
+	return (entry->key.index >= priv->prefetch_start) &&
+	       (entry->key.index <= priv->prefetch_end) &&
+	       (entry->key.scale == priv->scale);
+}
+
+// tracks how fast and which way the visible range moves
+static void
+_update_velocity (GspdfPageCachePrivate *priv,
+	                gint                   start)
+{
+	const gint64 now = g_get_monotonic_time ();
+	const gint moved = start - priv->start;
+	const gdouble dt = (now - priv->last_time) / (gdouble) G_USEC_PER_SEC;
+
+	priv->last_time = now;
+
+	if (moved == 0) {
+		return;
+	}
+
+	priv->direction = (moved > 0) ? 1 : -1;
+
+	// a pause or a jump starts a new gesture
+	if ((dt <= 0) || (dt > 1.0)) {
+		priv->velocity = 0;
+		return;
+	}
+
+	priv->velocity = (priv->velocity + ABS (moved) / dt) / 2;
+}
+
+static void
+_update_prefetch_range (GspdfPageCachePrivate *priv,
+	                      gint                   n_pages)
+{
+	gint ahead = 1, behind = 1;
+
+	if (priv->continuous) {
+		ahead = CLAMP (
+			(gint) ceil (priv->velocity * GSPDF_PAGE_CACHE_PREFETCH_TIME),
+			GSPDF_PAGE_CACHE_PREFETCH_MIN,
+			GSPDF_PAGE_CACHE_PREFETCH_MAX
+		);
+	}
+
+	if (priv->direction < 0) {
+		priv->prefetch_start = priv->start - ahead;
+		priv->prefetch_end = priv->end + behind;
+	} else {
+		priv->prefetch_start = priv->start - behind;
+		priv->prefetch_end = priv->end + ahead;
+	}
+
+	priv->prefetch_start = MAX (priv->prefetch_start, 0);
+	priv->prefetch_end = MIN (priv->prefetch_end, n_pages - 1);
+}
+
+// a cache in the background gets an even part of half the budget, the
+// one in front whatever the others leave
+static gsize
+_get_budget (GspdfPageCachePrivate *priv)
+{
+	gsize others = 0;
+	guint n_inactive = (priv->active) ? 0 : 1;
+
+	for (GList *iter = gspdf_page_cache_instances; iter; iter = iter->next) {
+		GspdfPageCachePrivate *other = (GspdfPageCachePrivate*) iter->data;
+
+		if (other == priv) {
+			continue;
+		}
+
+		others += other->bytes;
+
+		if (!other->active) {
+			n_inactive++;
+		}
+	}
+
+	if (!priv->active) {
+		return (gspdf_page_cache_budget / 2) / n_inactive;
+	}
+
+	return (others < gspdf_page_cache_budget) ? gspdf_page_cache_budget - others : 0;
+}
+
+// drops the least recently shown pages until the cache fits its budget,
+// the visible and prefetched ones are kept unless the tab is hidden
+static void
+gspdf_page_cache_task_renders_evict (GspdfPageCachePrivate *priv)
+{
+	GspdfPageCacheEntry *entry = NULL;
+
+	if (!priv->task_renders) {
+		return;
+	}
+
+	const gsize budget = _get_budget (priv);
+
+	while ((priv->bytes > budget) && priv->lru.tail) {
+		entry = (GspdfPageCacheEntry*) priv->lru.tail->data;
+
+		if (priv->active && _is_wanted (priv, entry)) {
+			break;
+		}
+
+		gspdf_page_cache_task_renders_remove (priv, entry);
+	}
+}
+
+// the share of every cache changes with the number of tabs in the
+// background, the background ones are trimmed first
+static void
+gspdf_page_cache_evict_all (void)
+{
+	for (GList *iter = gspdf_page_cache_instances; iter; iter = iter->next) {
+		GspdfPageCachePrivate *other = (GspdfPageCachePrivate*) iter->data;
+
+		if (!other->active) {
+			gspdf_page_cache_task_renders_evict (other);
+		}
+	}
+
+	for (GList *iter = gspdf_page_cache_instances; iter; iter = iter->next) {
+		GspdfPageCachePrivate *other = (GspdfPageCachePrivate*) iter->data;
+
+		if (other->active) {
+			gspdf_page_cache_task_renders_evict (other);
+		}
+	}
+}
+
+static gboolean
+gspdf_page_cache_evict_all_idle (gpointer user_data)
+{
+	gspdf_page_cache_evict_source = 0;
+	gspdf_page_cache_evict_all ();
+
+	return FALSE;
+}
+
+GspdfPageCache *
+gspdf_page_cache_new ()
+{
+	return g_object_new (GSPDF_TYPE_PAGE_CACHE, NULL);
+}
+
+void
+gspdf_page_cache_open_document (GspdfPageCache *page_cache,
+								                const gchar    *uri,
+								                const gchar    *password)
+{
+	g_return_if_fail (page_cache != NULL);
+	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
+	g_return_if_fail (uri != NULL);
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	if (priv->document) {
+		g_object_unref (priv->document);
+		priv->document = NULL;
+	}
+
+	if (priv->error) {
+		g_error_free (priv->error);
+		priv->error = NULL;
+	}
+
+	if (priv->uri) {
+		g_free (priv->uri);
+		priv->uri = NULL;
+	}
+
+	if (priv->password) {
+		g_free (priv->password);
+		priv->password = NULL;
+	}
+
+	gspdf_page_cache_task_renders_clear (priv);
+	g_hash_table_remove_all (priv->task_texts);
+	gspdf_page_cache_find_cancel (page_cache);
+
+	if (priv->task_index) {
+		_task_cancel_free_func (priv->task_index);
+		priv->task_index = NULL;
+	}
+
+	if (priv->doc_map) {
+		g_ptr_array_unref (priv->doc_map);
+		priv->doc_map = NULL;
+	}
+
+	priv->uri = g_strdup (uri);
+	priv->password = g_strdup (password);
+	priv->start = 0;
+	priv->end = 0;
+	priv->prefetch_start = 0;
+	priv->prefetch_end = 0;
+	priv->scale = 1.0;
+	priv->direction = 1;
+	priv->velocity = 0;
+
+	gspdf_task_loader_set (
+		GSPDF_TASK_LOADER (priv->task_loader),
+		priv->uri,
+		priv->password
+	);
+
+	gspdf_task_scheduler_push (
+		priv->task_scheduler,
+		priv->task_loader,
+		GSPDF_TASK_PRIORITY_HIGH
+	);
+}
+
+gchar *
+gspdf_page_cache_get_uri (GspdfPageCache *page_cache)
+{
+	g_return_val_if_fail (page_cache != NULL, NULL);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	return g_strdup (priv->uri);
+}
+
+GspdfDocument *
+gspdf_page_cache_get_document (GspdfPageCache  *page_cache,
+                               GError         **error)
+{
+	g_return_val_if_fail (page_cache != NULL, NULL);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	if (!priv->document) {
+		if (error) {
+			*error = gspdf_task_loader_get_gerror (
+				GSPDF_TASK_LOADER (priv->task_loader)
+			);
+		}
+
+		return NULL;
+	}
+
+	g_object_ref (priv->document);
+
+	return priv->document;
+}
+
+GPtrArray *
+gspdf_page_cache_get_document_map (GspdfPageCache *page_cache)
+{
+	g_return_val_if_fail (page_cache != NULL, NULL);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	if (!priv->doc_map) {
+		return NULL;
+	}
+
+	return g_ptr_array_ref (priv->doc_map);
+}
+
+void
+gspdf_page_cache_set_range (GspdfPageCache *page_cache,
+							              gint 			      start,
+							              gint 			      end,
+							              gdouble         scale)
+{
+	g_return_if_fail (page_cache != NULL);
+	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	g_return_if_fail (priv->document != NULL);
+
+	const gint n_pages = gspdf_document_get_n_pages (priv->document);
+
+	g_return_if_fail ((start >= 0) && (start < n_pages));
+	g_return_if_fail ((end >= 0) && (end < n_pages));
+	g_return_if_fail (end >= start);
+
+	_update_velocity (priv, start);
+
+	priv->start = start;
+	priv->end = end;
+	priv->scale = scale;
+
+	_update_prefetch_range (priv, n_pages);
+
+	GspdfPageCacheEntry *entry = NULL;
+	gint priority = 0;
+
+	for (gint i = priv->prefetch_start; i <= priv->prefetch_end; i++) {
+		_queue_text (priv, i);
+
+		// large pages are requested tile by tile when drawn
+		if (_is_tiled (priv, i, priv->scale)) {
+			continue;
+		}
+
+		priority = _get_render_priority (priv, i);
+		entry = gspdf_page_cache_task_renders_lookup (
+			priv->task_renders,
+			i,
+			priv->scale,
+			GSPDF_PAGE_CACHE_WHOLE_PAGE
+		);
+
+		if (entry) {
+			// still queued tasks get reordered against the new viewport
+			gspdf_task_set_priority (entry->task, priority);
+			g_queue_unlink (&priv->lru, &entry->link);
+			g_queue_push_head_link (&priv->lru, &entry->link);
+			continue;
+		}
+
+		_queue_render (
+			page_cache,
+			i,
+			GSPDF_PAGE_CACHE_WHOLE_PAGE,
+			NULL,
+			priority
+		);
+	}
+
+	// renders that left the range before finishing are of no use,
+	// finished ones stay until the budget pushes them out, except tiles
+	// which are only kept around the viewport
+	GHashTableIter iter;
+	gpointer value = NULL;
+	GSList *stale = NULL;
+
+	g_hash_table_iter_init (&iter, priv->task_renders);
+
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		entry = (GspdfPageCacheEntry*) value;
+
+		if (_is_wanted (priv, entry)) {
+			continue;
+		}
+
+		if ((entry->key.tile != GSPDF_PAGE_CACHE_WHOLE_PAGE) ||
+		    (gspdf_task_get_status (entry->task) != GSPDF_TASK_STATUS_OK)) {
+			stale = g_slist_prepend (stale, entry);
+		}
+	}
+
+	for (GSList *link = stale; link; link = link->next) {
+		gspdf_page_cache_task_renders_remove (priv, link->data);
+	}
+
+	g_slist_free (stale);
+
+	g_hash_table_foreach_remove (priv->task_texts, _task_texts_is_stale, priv);
+
+	gspdf_page_cache_task_renders_evict (priv);
+}
+
+void
+gspdf_page_cache_get_range (GspdfPageCache *page_cache,
+							              gint 		       *start,
+							              gint 		       *end)
+{
+	g_return_if_fail (page_cache != NULL);
+	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	if (start) {
+		*start = priv->start;
+	}
+
+	if (end) {
+		*end = priv->end;
+	}
+}
+
+void
+gspdf_page_cache_set_scale (GspdfPageCache *page_cache,
+							              gdouble 	      scale)
+{
+	g_return_if_fail (page_cache != NULL);
+	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
+
+	//priv->scale = scale;
+}
+
+cairo_surface_t *
+gspdf_page_cache_get_surface (GspdfPageCache *page_cache,
+							                gint 			      index)
+{
+	g_return_val_if_fail (page_cache != NULL, NULL);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	g_return_val_if_fail (priv->document != NULL, NULL);
+
+	GspdfPageCacheEntry *entry = gspdf_page_cache_task_renders_lookup (
+		priv->task_renders,
+		index,
+		priv->scale,
+		GSPDF_PAGE_CACHE_WHOLE_PAGE
+	);
+
+	if (!entry || gspdf_task_get_status (entry->task) != GSPDF_TASK_STATUS_OK) {
+		return NULL;
+	}
+
+	_upload (priv, entry);
+
+	return gspdf_task_render_get_surface (GSPDF_TASK_RENDER (entry->task));
+}
+
+// the page's glyph layout once its text task has run, selections are
+// computed from it without going back to the document
+static const GspdfTextLayout *
+_get_text_layout (GspdfPageCachePrivate *priv,
+	                gint                   index)
+{
+	GspdfTask *task = g_hash_table_lookup (priv->task_texts, GINT_TO_POINTER (index));
+
+	if (!task || (gspdf_task_get_status (task) != GSPDF_TASK_STATUS_OK)) {
+		return NULL;
+	}
+
+	return gspdf_task_text_get_text_layout (GSPDF_TASK_TEXT (task));
+}
+
+GList *
+gspdf_page_cache_get_selected_region (GspdfPageCache       *page_cache,
+									                    gint                  index,
+	                                    GspdfSelectionStyle   style,
+	                                    const GspdfRectangle *selection)
+{
+	g_return_val_if_fail (page_cache != NULL, NULL);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	g_return_val_if_fail (priv->document != NULL, NULL);
+	g_return_val_if_fail ((index >= priv->start) && (index <= priv->end), NULL);
+
+	const GspdfTextLayout *layout = _get_text_layout (priv, index);
+
+	if (layout && (style == GSPDF_SELECTION_GLYPH)) {
+		return gspdf_text_layout_get_selected_region (layout, selection);
+	}
+
+	GspdfDocumentPage *page = gspdf_document_get_page (priv->document, index);
+	GList *ret = gspdf_document_page_get_selected_region (page, style, selection);
+
+	g_object_unref (page);
+
+	return ret;
+}
+
+gchar *
+gspdf_page_cache_get_selected_text (GspdfPageCache       *page_cache,
+									                  gint                  index,
+	                                  GspdfSelectionStyle   style,
+	                                  const GspdfRectangle *selection)
+{
+	g_return_val_if_fail (page_cache != NULL, NULL);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	g_return_val_if_fail (priv->document != NULL, NULL);
+	g_return_val_if_fail ((index >= priv->start) && (index <= priv->end), NULL);
+
+	const GspdfTextLayout *layout = _get_text_layout (priv, index);
+
+	if (layout && (style == GSPDF_SELECTION_GLYPH)) {
+		return gspdf_text_layout_get_selected_text (layout, selection);
+	}
+
+	GspdfDocumentPage *page = gspdf_document_get_page (priv->document, index);
+	gchar *ret = gspdf_document_page_get_selected_text (page, style, selection);
+
+	g_object_unref (page);
+
+	return ret;
+}
+
+GList *
+gspdf_page_cache_get_text_mapping (GspdfPageCache *page_cache,
+							                     gint 		       index)
+{
+	g_return_val_if_fail (page_cache != NULL, NULL);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	g_return_val_if_fail (priv->document != NULL, NULL);
+
+	GspdfTask *task = g_hash_table_lookup (priv->task_texts, GINT_TO_POINTER (index));
+
+	// published by the task before it finishes
+	if (!task) {
+		return NULL;
+	}
+
+	return gspdf_task_text_get_text_mapping (GSPDF_TASK_TEXT (task));
+}
+
+const GspdfHitIndex *
+gspdf_page_cache_get_hit_index (GspdfPageCache *page_cache,
+                                gint            index)
+{
+	g_return_val_if_fail (page_cache != NULL, NULL);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	GspdfTask *task = g_hash_table_lookup (priv->task_texts, GINT_TO_POINTER (index));
+
+	// published by the task before it finishes
+	if (!task) {
+		return NULL;
+	}
+
+	return gspdf_task_text_get_hit_index (GSPDF_TASK_TEXT (task));
+}
+
+void
+gspdf_page_cache_clear (GspdfPageCache *page_cache)
+{
+	g_return_if_fail (page_cache != NULL);
+	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	g_return_if_fail (priv->document != NULL);
+
+	gspdf_page_cache_task_renders_clear (priv);
+	g_hash_table_remove_all (priv->task_texts);
+}
+
+void
+gspdf_page_cache_set_active (GspdfPageCache *page_cache,
+                             gboolean        active)
+{
+	g_return_if_fail (page_cache != NULL);
+	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
+
+	if (priv->active == active) {
+		return;
+	}
+
+	priv->active = active;
+
+	// move the renders still queued in front of or behind other tabs
+	GHashTableIter iter;
+	gpointer value = NULL;
+	GspdfPageCacheEntry *entry = NULL;
+
+	g_hash_table_iter_init (&iter, priv->task_renders);
+
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		entry = (GspdfPageCacheEntry*) value;
+
+		gspdf_task_set_priority (
+			entry->task,
+			_get_render_priority (priv, entry->key.index)
+		);
+	}
+
+	g_hash_table_iter_init (&iter, priv->task_texts);
+
+	gpointer key = NULL;
+
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		gspdf_task_set_priority (
+			(GspdfTask*) value,
+			_get_text_priority (priv, GPOINTER_TO_INT (key))
+		);
+	}
+
+	if (priv->task_index) {
+		gspdf_task_set_priority (
+			priv->task_index,
+			GSPDF_PAGE_CACHE_INDEX_PRIORITY +
+				((priv->active) ? 0 : GSPDF_PAGE_CACHE_BACKGROUND_PRIORITY)
+		);
+	}
+
+	// a tab going to the background gives its memory to the one in front
+	gspdf_page_cache_evict_all ();
+}
+
+gboolean
+gspdf_page_cache_get_active (GspdfPageCache *page_cache)
+{
+	g_return_val_if_fail (page_cache != NULL, FALSE);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), FALSE);
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
 	);
 
-	gspdf_task_scheduler_push (priv->task_scheduler, priv->task_loader, TRUE);
+	return priv->active;
 }
 
-gchar *
-gspdf_page_cache_get_uri (GspdfPageCache *page_cache)
+// the budget is shared by every cache, setting it on one sets it for all
+void
+gspdf_page_cache_set_budget (GspdfPageCache *page_cache,
+                             gsize           budget)
 {
-	g_return_val_if_fail (page_cache != NULL, NULL);
-	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+	g_return_if_fail (page_cache != NULL);
+	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
+
+	gspdf_page_cache_budget = budget;
+	gspdf_page_cache_evict_all ();
+}
+
+gsize
+gspdf_page_cache_get_budget (GspdfPageCache *page_cache)
+{
+	g_return_val_if_fail (page_cache != NULL, 0);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), 0);
+
+	return gspdf_page_cache_budget;
+}
+
+void
+gspdf_page_cache_set_continuous (GspdfPageCache *page_cache,
+                                 gboolean        continuous)
+{
+	g_return_if_fail (page_cache != NULL);
+	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
 
 	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
 		page_cache
 	);
 
-	return g_strdup (priv->uri);
+	priv->continuous = continuous;
 }
 
-GspdfDocument *
-gspdf_page_cache_get_document (GspdfPageCache  *page_cache,
-                               GError         **error)
+void
+gspdf_page_cache_set_window (GspdfPageCache *page_cache,
+                             GdkWindow      *window)
 {
-	g_return_val_if_fail (page_cache != NULL, NULL);
-	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+	g_return_if_fail (page_cache != NULL);
+	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
 
 	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
 		page_cache
 	);
 
-	if (!priv->document) {
-		if (error) {
-			*error = gspdf_task_loader_get_gerror (
-				GSPDF_TASK_LOADER (priv->task_loader)
-			);
-		}
+	if (priv->window == window) {
+		return;
+	}
 
-		return NULL;
+	if (priv->window) {
+		g_object_remove_weak_pointer (G_OBJECT (priv->window), (gpointer*) &priv->window);
 	}
 
-	g_object_ref (priv->document);
+	priv->window = window;
 
-	return priv->document;
+	if (priv->window) {
+		g_object_add_weak_pointer (G_OBJECT (priv->window), (gpointer*) &priv->window);
+	}
 }
 
-GPtrArray *
-gspdf_page_cache_get_document_map (GspdfPageCache *page_cache)
+// a finished render of the page at another scale, to be stretched in
+// place of the page until the render at the current scale is done.
+// Prefers the closest scale above the current one.
+cairo_surface_t *
+gspdf_page_cache_get_placeholder (GspdfPageCache *page_cache,
+                                  gint            index,
+                                  gdouble        *scale)
 {
 	g_return_val_if_fail (page_cache != NULL, NULL);
 	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
@@ -282,214 +1742,379 @@ gspdf_page_cache_get_document_map (GspdfPageCache *page_cache)
 		page_cache
 	);
 
-	if (!priv->task_loader) {
-		return NULL;
+	GSList *iter = g_hash_table_lookup (
+		priv->task_renders_by_index,
+		GINT_TO_POINTER (index)
+	);
+
+	GspdfPageCacheEntry *best = NULL;
+	GspdfPageCacheEntry *entry = NULL;
+
+	while (iter) {
+		entry = (GspdfPageCacheEntry*) iter->data;
+		iter = iter->next;
+
+		if ((entry->key.scale == priv->scale) ||
+		    (entry->key.tile != GSPDF_PAGE_CACHE_WHOLE_PAGE)) {
+			continue;
+		}
+
+		if (gspdf_task_get_status (entry->task) != GSPDF_TASK_STATUS_OK) {
+			continue;
+		}
+
+		if (!best) {
+			best = entry;
+		} else if (best->key.scale < priv->scale) {
+			if (entry->key.scale > best->key.scale) {
+				best = entry;
+			}
+		} else if ((entry->key.scale > priv->scale) &&
+		           (entry->key.scale < best->key.scale)) {
+			best = entry;
+		}
 	}
 
-	if (gspdf_task_get_status (priv->task_loader) != GSPDF_TASK_STATUS_OK) {
+	if (!best) {
 		return NULL;
 	}
 
-	return gspdf_task_loader_get_document_map (
-		GSPDF_TASK_LOADER (priv->task_loader)
+	if (scale) {
+		*scale = best->key.scale;
+	}
+
+	_upload (priv, best);
+
+	return gspdf_task_render_get_surface (GSPDF_TASK_RENDER (best->task));
+}
+
+gboolean
+gspdf_page_cache_is_tiled (GspdfPageCache *page_cache,
+                           gint            index)
+{
+	g_return_val_if_fail (page_cache != NULL, FALSE);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), FALSE);
+
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
 	);
+
+	return _is_tiled (priv, index, priv->scale);
 }
 
-void
-gspdf_page_cache_set_range (GspdfPageCache *page_cache,
-							              gint 			      start,
-							              gint 			      end,
-							              gdouble         scale)
+static gboolean
+_rectangle_intersects (const GspdfRectangle *a,
+	                     const GspdfRectangle *b)
 {
-	g_return_if_fail (page_cache != NULL);
-	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
+	return (a->x < (b->x + b->width)) && (b->x < (a->x + a->width)) &&
+	       (a->y < (b->y + b->height)) && (b->y < (a->y + a->height));
+}
+
+// returns the finished tiles of a tiled page intersecting area, in pixels
+// of the page at the current scale, as a GList of GspdfPageCacheTile.
+// Missing tiles around area are queued, tiles further away are dropped.
+GList *
+gspdf_page_cache_get_tiles (GspdfPageCache       *page_cache,
+                            gint                  index,
+                            const GspdfRectangle *area)
+{
+	g_return_val_if_fail (page_cache != NULL, NULL);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+	g_return_val_if_fail (area != NULL, NULL);
 
 	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
 		page_cache
 	);
 
-	g_return_if_fail (priv->document != NULL);
-	g_return_if_fail ((start >= 0) && (start < gspdf_document_get_n_pages (priv->document)));
-	g_return_if_fail ((end >= 0) && (end < gspdf_document_get_n_pages (priv->document)));
-	g_return_if_fail (end >= start);
+	g_return_val_if_fail (priv->document != NULL, NULL);
 
-	priv->start = start;
-	priv->end = end;
-	priv->scale = scale;
+	gdouble width = 0, height = 0;
 
-	GSList *temp = NULL;
-	GspdfTask *task = NULL;
-	gboolean found = FALSE;
+	if (!_get_page_size (priv, index, priv->scale, &width, &height)) {
+		return NULL;
+	}
 
-	for (gint i = priv->start; i <= priv->end; i++) {
-		if (priv->task_renders) {
-			GSList *iter = priv->task_renders;
+	const gint size = GSPDF_PAGE_CACHE_TILE_SIZE;
+	const gint cols = (gint) ceil (width / size);
+	const gint rows = (gint) ceil (height / size);
 
-			while (iter) {
-				task = (GspdfTask*) iter->data;
+	// one tile of margin around the viewport
+	const gint col_start = MAX ((gint) floor (area->x / size) - 1, 0);
+	const gint col_end = MIN ((gint) floor ((area->x + area->width) / size) + 1, cols - 1);
+	const gint row_start = MAX ((gint) floor (area->y / size) - 1, 0);
+	const gint row_end = MIN ((gint) floor ((area->y + area->height) / size) + 1, rows - 1);
 
-				if (gspdf_task_render_get_index (GSPDF_TASK_RENDER (task)) == i) {
-					temp = g_slist_append (temp, task);
-					g_object_ref (task);
-					found = TRUE;
-					break;
-				}
+	GSList *iter = g_hash_table_lookup (
+		priv->task_renders_by_index,
+		GINT_TO_POINTER (index)
+	);
 
-				iter = iter->next;
-			}
-		}
+	GspdfPageCacheEntry *entry = NULL;
+	GSList *stale = NULL;
 
-		if (found) {
-			found = FALSE;
+	while (iter) {
+		entry = (GspdfPageCacheEntry*) iter->data;
+		iter = iter->next;
+
+		if (entry->key.tile == GSPDF_PAGE_CACHE_WHOLE_PAGE) {
 			continue;
 		}
 
-		task = gspdf_task_render_new ();
+		const gint col = entry->key.tile % cols;
+		const gint row = entry->key.tile / cols;
 
-		gspdf_task_render_set (
-			GSPDF_TASK_RENDER (task),
-			priv->document,
-			i,
-			priv->scale
-		);
+		if ((entry->key.scale != priv->scale) ||
+		    (col < col_start) || (col > col_end) ||
+		    (row < row_start) || (row > row_end))
+		{
+			stale = g_slist_prepend (stale, entry);
+		}
+	}
 
-		gspdf_task_set_finished_callback (
-			task,
-			task_render_finished_cb,
-			page_cache
-		);
+	for (GSList *link = stale; link; link = link->next) {
+		gspdf_page_cache_task_renders_remove (priv, link->data);
+	}
 
-		temp = g_slist_append (temp, task);
+	g_slist_free (stale);
 
-		gspdf_task_scheduler_push (priv->task_scheduler, task, TRUE);
-	}
+	GList *ret = NULL;
+	GspdfRectangle rect;
 
-	if (priv->task_renders) {
-		gspdf_page_cache_task_renders_clear (priv->task_renders);
-		priv->task_renders = NULL;
+	for (gint row = row_start; row <= row_end; row++) {
+		for (gint col = col_start; col <= col_end; col++) {
+			const gint tile = (row * cols) + col;
+
+			rect.x = col * size;
+			rect.y = row * size;
+			rect.width = MIN (size, width - rect.x);
+			rect.height = MIN (size, height - rect.y);
+
+			const gboolean visible = _rectangle_intersects (&rect, area);
+
+			entry = gspdf_page_cache_task_renders_lookup (
+				priv->task_renders,
+				index,
+				priv->scale,
+				tile
+			);
+
+			if (!entry) {
+				gint priority = _get_render_priority (priv, index);
+
+				if (!visible) {
+					priority += GSPDF_TASK_PRIORITY_LOW;
+				}
+
+				_queue_render (
+					page_cache,
+					index,
+					tile,
+					&rect,
+					priority
+				);
+
+				continue;
+			}
+
+			g_queue_unlink (&priv->lru, &entry->link);
+			g_queue_push_head_link (&priv->lru, &entry->link);
+
+			if (!visible) {
+				continue;
+			}
+
+			if (gspdf_task_get_status (entry->task) != GSPDF_TASK_STATUS_OK) {
+				continue;
+			}
+
+			_upload (priv, entry);
+
+			GspdfPageCacheTile *ret_tile = g_malloc0 (sizeof (GspdfPageCacheTile));
+			ret_tile->surface = gspdf_task_render_get_surface (
+				GSPDF_TASK_RENDER (entry->task)
+			);
+			ret_tile->rect = entry->rect;
+
+			ret = g_list_prepend (ret, ret_tile);
+		}
 	}
 
-	priv->task_renders = temp;
+	return ret;
 }
 
 void
-gspdf_page_cache_get_range (GspdfPageCache *page_cache,
-							              gint 		       *start,
-							              gint 		       *end)
+gspdf_page_cache_tile_free (GspdfPageCacheTile *tile)
 {
-	g_return_if_fail (page_cache != NULL);
-	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
-
-	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
-		page_cache
-	);
+	g_return_if_fail (tile != NULL);
 
-	if (start) {
-		*start = priv->start;
+	if (tile->surface) {
+		cairo_surface_destroy (tile->surface);
 	}
 
-	if (end) {
-		*end = priv->end;
-	}
+	g_free (tile);
 }
 
+// searches every page for text, from start to the last page and then
+// from the first one, results come through "find-result" in that order
 void
-gspdf_page_cache_set_scale (GspdfPageCache *page_cache,
-							              gdouble 	      scale)
+gspdf_page_cache_find (GspdfPageCache *page_cache,
+                       const gchar    *text,
+                       GspdfFindFlags  options,
+                       gint            start)
 {
 	g_return_if_fail (page_cache != NULL);
 	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
-
-	//priv->scale = scale;
-}
-
-GdkPixbuf *
-gspdf_page_cache_get_pixbuf (GspdfPageCache *page_cache,
-							               gint 			     index)
-{
-	g_return_val_if_fail (page_cache != NULL, NULL);
-	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+	g_return_if_fail (text != NULL);
 
 	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
 		page_cache
 	);
 
-	g_return_val_if_fail (priv->document != NULL, NULL);
-	g_return_val_if_fail ((index >= priv->start) && (index <= priv->end), NULL);
-	g_return_val_if_fail (priv->task_renders != NULL, NULL);
+	g_return_if_fail (priv->document != NULL);
 
-	GSList *iter = priv->task_renders;
-	GspdfTask *task = NULL;
-	GdkPixbuf *ret = NULL;
+	gspdf_page_cache_find_cancel (page_cache);
 
-	while (iter) {
-		task = (GspdfTask*) iter->data;
+	const gint n_pages = gspdf_document_get_n_pages (priv->document);
 
-		if (gspdf_task_render_get_index (GSPDF_TASK_RENDER (task)) == index) {
-			if (gspdf_task_get_status (task) == GSPDF_TASK_STATUS_OK) {
-				ret = gspdf_task_render_get_pixbuf (GSPDF_TASK_RENDER (task));
-			}
+	g_return_if_fail ((start >= 0) && (start < n_pages));
 
-			break;
+	// once the index is built, only the pages having every word of text
+	// are searched
+	GArray *pages = NULL;
+
+	if (priv->task_index &&
+	    (gspdf_task_get_status (priv->task_index) == GSPDF_TASK_STATUS_OK))
+	{
+		GspdfTextIndex *text_index = gspdf_task_index_get_text_index (
+			GSPDF_TASK_INDEX (priv->task_index)
+		);
+
+		if (text_index) {
+			pages = gspdf_text_index_lookup (text_index, text);
 		}
+	}
 
-		iter = iter->next;
+	if (!pages) {
+		pages = g_array_sized_new (FALSE, FALSE, sizeof (gint), n_pages);
+
+		for (gint i = 0; i < n_pages; i++) {
+			g_array_append_val (pages, i);
+		}
 	}
 
-	return ret;
+	// pages is ascending, the search goes round from the first page at or
+	// after start
+	guint first = 0;
+
+	while ((first < pages->len) && (g_array_index (pages, gint, first) < start)) {
+		first++;
+	}
+
+	GArray *order = g_array_sized_new (FALSE, FALSE, sizeof (gint), pages->len);
+
+	g_array_append_vals (order, &g_array_index (pages, gint, first), pages->len - first);
+	g_array_append_vals (order, pages->data, first);
+	g_array_unref (pages);
+
+	priv->find_running = TRUE;
+
+	for (guint i = 0; i < order->len; i += GSPDF_PAGE_CACHE_FIND_CHUNK) {
+		GspdfTask *task = gspdf_task_find_new ();
+
+		gspdf_task_find_set_pages (
+			GSPDF_TASK_FIND (task),
+			priv->document,
+			text,
+			options,
+			&g_array_index (order, gint, i),
+			MIN (GSPDF_PAGE_CACHE_FIND_CHUNK, order->len - i)
+		);
+		gspdf_task_set_progress_callback (task, task_find_progress_cb, page_cache);
+		gspdf_task_set_finished_callback (task, task_find_progress_cb, page_cache);
+		g_ptr_array_add (priv->find_tasks, task);
+
+		gspdf_task_scheduler_push (
+			priv->task_scheduler,
+			task,
+			GSPDF_PAGE_CACHE_FIND_PRIORITY + (i / GSPDF_PAGE_CACHE_FIND_CHUNK) +
+				((priv->active) ? 0 : GSPDF_PAGE_CACHE_BACKGROUND_PRIORITY)
+		);
+	}
+
+	g_array_unref (order);
+
+	// nothing to search, it still finishes through the flush
+	if (priv->find_tasks->len == 0) {
+		task_find_progress_cb (NULL, page_cache);
+	}
 }
 
-GList *
-gspdf_page_cache_get_selected_region (GspdfPageCache       *page_cache,
-									                    gint                  index,
-	                                    GspdfSelectionStyle   style,
-	                                    const GspdfRectangle *selection)
+void
+gspdf_page_cache_find_cancel (GspdfPageCache *page_cache)
 {
-	g_return_val_if_fail (page_cache != NULL, NULL);
-	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+	g_return_if_fail (page_cache != NULL);
+	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
 
 	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
 		page_cache
 	);
 
-	g_return_val_if_fail (priv->document != NULL, NULL);
-	g_return_val_if_fail ((index >= priv->start) && (index <= priv->end), NULL);
+	// pending chunks are cancelled as they are dropped
+	g_ptr_array_set_size (priv->find_tasks, 0);
+	g_ptr_array_set_size (priv->find_results, 0);
+	priv->find_next = 0;
+	priv->find_running = FALSE;
+	priv->find_n_matches = 0;
+	priv->find_generation++;
+}
 
-	GspdfDocumentPage *page = gspdf_document_get_page (priv->document, index);
-	GList *ret = gspdf_document_page_get_selected_region (page, style, selection);
+gboolean
+gspdf_page_cache_is_finding (GspdfPageCache *page_cache)
+{
+	g_return_val_if_fail (page_cache != NULL, FALSE);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), FALSE);
 
-	g_object_unref (page);
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
 
-	return ret;
+	return priv->find_running;
 }
 
-gchar *
-gspdf_page_cache_get_selected_text (GspdfPageCache       *page_cache,
-									                  gint                  index,
-	                                  GspdfSelectionStyle   style,
-	                                  const GspdfRectangle *selection)
+gint
+gspdf_page_cache_get_n_find_results (GspdfPageCache *page_cache)
 {
-	g_return_val_if_fail (page_cache != NULL, NULL);
-	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
+	g_return_val_if_fail (page_cache != NULL, 0);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), 0);
 
 	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
 		page_cache
 	);
 
-	g_return_val_if_fail (priv->document != NULL, NULL);
-	g_return_val_if_fail ((index >= priv->start) && (index <= priv->end), NULL);
+	return (gint) priv->find_results->len;
+}
 
-	GspdfDocumentPage *page = gspdf_document_get_page (priv->document, index);
-	gchar *ret = gspdf_document_page_get_selected_text (page, style, selection);
+// the hits in all the results so far
+gint
+gspdf_page_cache_get_n_find_matches (GspdfPageCache *page_cache)
+{
+	g_return_val_if_fail (page_cache != NULL, 0);
+	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), 0);
 
-	g_object_unref (page);
+	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
+		page_cache
+	);
 
-	return ret;
+	return priv->find_n_matches;
 }
 
+// the GspdfRectangle hits on the page of the nth result, owned by the
+// cache until the next search, match is the number of hits before them
 GList *
-gspdf_page_cache_get_text_mapping (GspdfPageCache *page_cache,
-							                     gint 		       index)
+gspdf_page_cache_get_find_result (GspdfPageCache *page_cache,
+                                  gint            n,
+                                  gint           *index,
+                                  gint           *match)
 {
 	g_return_val_if_fail (page_cache != NULL, NULL);
 	g_return_val_if_fail (GSPDF_PAGE_CACHE (page_cache), NULL);
@@ -498,39 +2123,17 @@ gspdf_page_cache_get_text_mapping (GspdfPageCache *page_cache,
 		page_cache
 	);
 
-	g_return_val_if_fail (priv->document != NULL, NULL);
-	g_return_val_if_fail ((index >= priv->start) && (index <= priv->end), NULL);
-
-	GList *iter = priv->task_renders;
-	GspdfTask *task_render = NULL;
-
-	while (iter) {
-		task_render = (GspdfTask*) iter->data;
+	g_return_val_if_fail ((n >= 0) && ((guint) n < priv->find_results->len), NULL);
 
-		if (task_render) {
-			if (gspdf_task_render_get_index (GSPDF_TASK_RENDER (task_render)) == index) {
-				return gspdf_task_render_get_text_mapping (
-					GSPDF_TASK_RENDER (task_render)
-				);
-			}
-		}
+	GspdfPageCacheFindResult *result = g_ptr_array_index (priv->find_results, n);
 
-		iter = iter->next;
+	if (index) {
+		*index = result->index;
 	}
-}
-
-void
-gspdf_page_cache_clear (GspdfPageCache *page_cache)
-{
-	g_return_if_fail (page_cache != NULL);
-	g_return_if_fail (GSPDF_PAGE_CACHE (page_cache));
-
-	GspdfPageCachePrivate *priv = gspdf_page_cache_get_instance_private (
-		page_cache
-	);
 
-	g_return_if_fail (priv->document != NULL);
+	if (match) {
+		*match = result->match;
+	}
 
-	gspdf_page_cache_task_renders_clear (priv->task_renders);
-	priv->task_renders = NULL;
+	return result->rects;
 }
@@ -20,6 +20,10 @@
 #include <glib-object.h>
 #endif
 
+#ifndef __GTK_H__
+#include <gtk/gtk.h>
+#endif
+
 #ifndef GSPDF_DOC_H
 #include "gspdf-document/gspdf-doc.h"
 #endif
@@ -30,6 +34,11 @@
 
 G_BEGIN_DECLS
 
+typedef struct {
+	cairo_surface_t *surface;
+	GspdfRectangle   rect;
+} GspdfPageCacheTile;
+
 #define GSPDF_TYPE_PAGE_CACHE gspdf_page_cache_get_type ()
 G_DECLARE_FINAL_TYPE (
 	GspdfPageCache,
@@ -72,9 +81,14 @@ void
 gspdf_page_cache_set_scale (GspdfPageCache *page_cache,
 							              gdouble 	      scale);
 
-GdkPixbuf *
-gspdf_page_cache_get_pixbuf (GspdfPageCache *page_cache,
-							               gint 			     index);
+cairo_surface_t *
+gspdf_page_cache_get_surface (GspdfPageCache *page_cache,
+							                gint 			      index);
+
+cairo_surface_t *
+gspdf_page_cache_get_placeholder (GspdfPageCache *page_cache,
+                                  gint            index,
+                                  gdouble        *scale);
 
 GList *
 gspdf_page_cache_get_selected_region (GspdfPageCache       *page_cache,
@@ -92,9 +106,71 @@ GList *
 gspdf_page_cache_get_text_mapping (GspdfPageCache *page_cache,
 							                     gint 		       index);
 
+const GspdfHitIndex *
+gspdf_page_cache_get_hit_index (GspdfPageCache *page_cache,
+                                gint            index);
+
 void
 gspdf_page_cache_clear (GspdfPageCache *page_cache);
 
+void
+gspdf_page_cache_set_active (GspdfPageCache *page_cache,
+                             gboolean        active);
+
+gboolean
+gspdf_page_cache_get_active (GspdfPageCache *page_cache);
+
+void
+gspdf_page_cache_set_budget (GspdfPageCache *page_cache,
+                             gsize           budget);
+
+gsize
+gspdf_page_cache_get_budget (GspdfPageCache *page_cache);
+
+void
+gspdf_page_cache_set_continuous (GspdfPageCache *page_cache,
+                                 gboolean        continuous);
+
+void
+gspdf_page_cache_set_window (GspdfPageCache *page_cache,
+                             GdkWindow      *window);
+
+gboolean
+gspdf_page_cache_is_tiled (GspdfPageCache *page_cache,
+                           gint            index);
+
+GList *
+gspdf_page_cache_get_tiles (GspdfPageCache       *page_cache,
+                            gint                  index,
+                            const GspdfRectangle *area);
+
+void
+gspdf_page_cache_tile_free (GspdfPageCacheTile *tile);
+
+
+void
+gspdf_page_cache_find (GspdfPageCache *page_cache,
+                       const gchar    *text,
+                       GspdfFindFlags  options,
+                       gint            start);
+
+void
+gspdf_page_cache_find_cancel (GspdfPageCache *page_cache);
+
+gboolean
+gspdf_page_cache_is_finding (GspdfPageCache *page_cache);
+
+gint
+gspdf_page_cache_get_n_find_results (GspdfPageCache *page_cache);
+
+gint
+gspdf_page_cache_get_n_find_matches (GspdfPageCache *page_cache);
+
+GList *
+gspdf_page_cache_get_find_result (GspdfPageCache *page_cache,
+                                  gint            n,
+                                  gint           *index,
+                                  gint           *match);
 
 G_END_DECLS
 
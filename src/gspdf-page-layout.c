@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2017, Fajar Dwi Darmanto <fajardwidarm@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include "gspdf-page-layout.h"
+
+// the vertical layout of a document in continuous mode at one scale,
+// pages stacked top to bottom each followed by spacing
+struct _GspdfPageLayout {
+	GPtrArray *doc_map;
+	gdouble    scale;
+	gdouble    spacing;
+
+	gint       n_pages;
+	// n_pages + 1 entries, offsets[i] is the top of page i and
+	// offsets[n_pages] the total height, all scaled
+	gdouble   *offsets;
+	gdouble    max_width;
+	gdouble    max_height;
+};
+
+GspdfPageLayout *
+gspdf_page_layout_new (GPtrArray *doc_map,
+                       gdouble    scale,
+                       gdouble    spacing)
+{
+	g_return_val_if_fail (doc_map != NULL, NULL);
+
+	GspdfPageLayout *ret = g_malloc0 (sizeof (GspdfPageLayout));
+
+	ret->doc_map = g_ptr_array_ref (doc_map);
+	ret->scale = scale;
+	ret->spacing = spacing;
+	ret->n_pages = (gint) doc_map->len;
+	ret->offsets = g_malloc ((ret->n_pages + 1) * sizeof (gdouble));
+	ret->offsets[0] = 0;
+
+	gspdf_page_layout_update (ret, 0);
+
+	return ret;
+}
+
+// the sizes of pages from start on changed in the document map
+void
+gspdf_page_layout_update (GspdfPageLayout *layout,
+                          gint             start)
+{
+	g_return_if_fail (layout != NULL);
+	g_return_if_fail ((start >= 0) && (start <= layout->n_pages));
+
+	GspdfDocMap *map = NULL;
+
+	for (gint i = start; i < layout->n_pages; i++) {
+		map = (GspdfDocMap*) g_ptr_array_index (layout->doc_map, i);
+
+		layout->offsets[i + 1] = layout->offsets[i] +
+			(map->height * layout->scale) + layout->spacing;
+	}
+
+	// a page may have shrunk, the maxima can't be patched
+	layout->max_width = 0;
+	layout->max_height = 0;
+
+	for (gint i = 0; i < layout->n_pages; i++) {
+		map = (GspdfDocMap*) g_ptr_array_index (layout->doc_map, i);
+
+		if (map->width > layout->max_width) {
+			layout->max_width = map->width;
+		}
+
+		if (map->height > layout->max_height) {
+			layout->max_height = map->height;
+		}
+	}
+}
+
+void
+gspdf_page_layout_free (GspdfPageLayout *layout)
+{
+	g_return_if_fail (layout != NULL);
+
+	g_ptr_array_unref (layout->doc_map);
+	g_free (layout->offsets);
+	g_free (layout);
+}
+
+// whether the layout still describes doc_map at scale and spacing
+gboolean
+gspdf_page_layout_is_valid (GspdfPageLayout *layout,
+                            GPtrArray       *doc_map,
+                            gdouble          scale,
+                            gdouble          spacing)
+{
+	g_return_val_if_fail (layout != NULL, FALSE);
+
+	return (layout->doc_map == doc_map) &&
+	       (layout->n_pages == (gint) doc_map->len) &&
+	       (layout->scale == scale) &&
+	       (layout->spacing == spacing);
+}
+
+gint
+gspdf_page_layout_get_n_pages (GspdfPageLayout *layout)
+{
+	g_return_val_if_fail (layout != NULL, 0);
+
+	return layout->n_pages;
+}
+
+// unscaled
+gdouble
+gspdf_page_layout_get_max_width (GspdfPageLayout *layout)
+{
+	g_return_val_if_fail (layout != NULL, -1);
+
+	return layout->max_width;
+}
+
+// unscaled
+gdouble
+gspdf_page_layout_get_max_height (GspdfPageLayout *layout)
+{
+	g_return_val_if_fail (layout != NULL, -1);
+
+	return layout->max_height;
+}
+
+gdouble
+gspdf_page_layout_get_total_height (GspdfPageLayout *layout)
+{
+	g_return_val_if_fail (layout != NULL, -1);
+
+	return layout->offsets[layout->n_pages];
+}
+
+gdouble
+gspdf_page_layout_get_offset (GspdfPageLayout *layout,
+                              gint             index)
+{
+	g_return_val_if_fail (layout != NULL, -1);
+	g_return_val_if_fail ((index >= 0) && (index <= layout->n_pages), -1);
+
+	return layout->offsets[index];
+}
+
+// the page whose slot, the page and the spacing below it, contains y:
+// the first page with y < offsets[i + 1], -1 when y is past the end
+gint
+gspdf_page_layout_get_page_at (GspdfPageLayout *layout,
+                               gdouble          y)
+{
+	g_return_val_if_fail (layout != NULL, -1);
+
+	gint low = 0, high = layout->n_pages;
+
+	while (low < high) {
+		const gint mid = low + ((high - low) / 2);
+
+		if (y < layout->offsets[mid + 1]) {
+			high = mid;
+		} else {
+			low = mid + 1;
+		}
+	}
+
+	return (low < layout->n_pages) ? low : -1;
+}
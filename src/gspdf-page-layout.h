@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2017, Fajar Dwi Darmanto <fajardwidarm@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef GSPDF_PAGE_LAYOUT_H
+#define GSPDF_PAGE_LAYOUT_H
+
+#ifndef __G_LIB_H__
+#include <glib.h>
+#endif
+
+#ifndef GSPDF_TASK_LIST_H
+#include "gspdf-task-list.h"
+#endif
+
+G_BEGIN_DECLS
+
+struct _GspdfPageLayout;
+typedef struct _GspdfPageLayout GspdfPageLayout;
+
+GspdfPageLayout *gspdf_page_layout_new (
+	GPtrArray *doc_map, gdouble scale, gdouble spacing);
+
+void gspdf_page_layout_free (GspdfPageLayout *layout);
+
+void gspdf_page_layout_update (GspdfPageLayout *layout, gint start);
+
+gboolean gspdf_page_layout_is_valid (
+	GspdfPageLayout *layout, GPtrArray *doc_map, gdouble scale, gdouble spacing);
+
+gint gspdf_page_layout_get_n_pages (GspdfPageLayout *layout);
+
+gdouble gspdf_page_layout_get_max_width (GspdfPageLayout *layout);
+
+gdouble gspdf_page_layout_get_max_height (GspdfPageLayout *layout);
+
+gdouble gspdf_page_layout_get_total_height (GspdfPageLayout *layout);
+
+gdouble gspdf_page_layout_get_offset (GspdfPageLayout *layout, gint index);
+
+gint gspdf_page_layout_get_page_at (GspdfPageLayout *layout, gdouble y);
+
+G_END_DECLS
+
+#endif
@@ -14,11 +14,21 @@
  */
 
 #include "gspdf-task-list.h"
+#include "gspdf-util/gspdf-sidecar.h"
 
 /**
  * GspdfTaskLoader
  */
 
+// pages measured before the document is published, the size of the
+// others is guessed from them until they are measured too
+#define GSPDF_TASK_LOADER_SAMPLE_PAGES 4
+// how often measured sizes are reported while the loader runs
+#define GSPDF_TASK_LOADER_PROGRESS_INTERVAL (100 * G_TIME_SPAN_MILLISECOND)
+// sidecar kind of the page sizes of a fully measured document
+#define GSPDF_TASK_LOADER_SIDECAR "page-sizes"
+#define GSPDF_TASK_LOADER_SIDECAR_VERSION 1
+
 typedef struct {
 
 	gchar         *uri;
@@ -26,8 +36,18 @@ typedef struct {
 	GspdfDocument *document;
 	GError        *error;
 
+	// published with estimated sizes, owned by the main thread
 	GPtrArray     *doc_map;
 
+	// true sizes measured by the worker, sizes[i] is page i,
+	// applied of them have been copied into doc_map
+	GArray        *sizes;
+	guint          applied;
+
+	// bumped by every set, a run of an older generation stops
+	gint           generation;
+	GMutex         mutex;
+
 } GspdfTaskLoaderPrivate;
 
 struct _GspdfTaskLoader {
@@ -47,24 +67,22 @@ _doc_map_free_func (gpointer data)
 	g_free (doc_map);
 }
 
-static GPtrArray *
-_doc_map_init (GspdfDocument *doc)
+static void
+_doc_map_measure (GspdfDocument *doc,
+	                gint           index,
+	                GspdfDocMap   *map)
 {
-	GPtrArray *ret = g_ptr_array_new_with_free_func (_doc_map_free_func);
-	gint pages = gspdf_document_get_n_pages (doc);
-	GspdfDocumentPage *page = NULL;
-	GspdfDocMap *map = NULL;
-
-	for (gint i = 0; i < pages; i++) {
-		page = gspdf_document_get_page (doc, i);
-		map = g_malloc0 (sizeof (GspdfDocMap));
-		map->width = gspdf_document_page_get_width (page);
-		map->height = gspdf_document_page_get_height (page);
-		g_ptr_array_add (ret, map);
-		g_object_unref (page);
-	}
+	GspdfDocumentPage *page = gspdf_document_get_page (doc, index);
+	map->width = gspdf_document_page_get_width (page);
+	map->height = gspdf_document_page_get_height (page);
+	g_object_unref (page);
+}
 
-	return ret;
+static gboolean
+_is_current (GspdfTaskLoaderPrivate *priv,
+	           gint                    generation)
+{
+	return g_atomic_int_get (&priv->generation) == generation;
 }
 
 static gboolean
@@ -75,35 +93,157 @@ gspdf_task_loader_run (GspdfTask *task)
 		task_loader
 	);
 
-	g_return_val_if_fail (priv->uri != NULL, FALSE);
+	g_mutex_lock (&priv->mutex);
+	const gint generation = priv->generation;
+	gchar *uri = g_strdup (priv->uri);
+	gchar *password = g_strdup (priv->password);
+	g_mutex_unlock (&priv->mutex);
 
-	if (priv->document) {
-		g_object_unref (priv->document);
-		priv->document = NULL;
+	g_return_val_if_fail (uri != NULL, FALSE);
+
+	GError *error = NULL;
+	GspdfDocument *document = gspdf_document_new_from_file (uri, password, &error);
+
+	g_free (password);
+
+	if (!document) {
+		g_free (uri);
+
+		g_mutex_lock (&priv->mutex);
+
+		if (_is_current (priv, generation)) {
+			priv->error = error;
+			error = NULL;
+		}
+
+		g_mutex_unlock (&priv->mutex);
+
+		if (error) {
+			g_error_free (error);
+		}
+
+		return FALSE;
 	}
 
-	if (priv->error) {
-		g_error_free (priv->error);
-		priv->error = NULL;
+	const gint n_pages = gspdf_document_get_n_pages (document);
+	gint n_sample = MIN (n_pages, GSPDF_TASK_LOADER_SAMPLE_PAGES);
+	GArray *sizes = g_array_sized_new (FALSE, TRUE, sizeof (GspdfDocMap), n_pages);
+	GspdfDocMap estimate = { 0, 0 };
+	GspdfDocMap size;
+
+	// a document opened before has its sizes on disk, nothing to measure
+	GspdfFileId file_id;
+	const gboolean has_id = gspdf_file_id_query (uri, &file_id);
+	GBytes *stored = (has_id) ?
+		gspdf_sidecar_load (
+			GSPDF_TASK_LOADER_SIDECAR,
+			GSPDF_TASK_LOADER_SIDECAR_VERSION,
+			uri,
+			&file_id
+		) : NULL;
+
+	if (stored && (g_bytes_get_size (stored) == n_pages * sizeof (GspdfDocMap))) {
+		g_array_append_vals (sizes, g_bytes_get_data (stored, NULL), n_pages);
+		n_sample = n_pages;
 	}
 
-	if (priv->doc_map) {
-		g_ptr_array_unref (priv->doc_map);
-		priv->doc_map = NULL;
+	if (stored) {
+		g_bytes_unref (stored);
 	}
 
-	priv->document = gspdf_document_new_from_file (
-		priv->uri,
-		priv->password,
-		&priv->error
-	);
+	for (gint i = sizes->len; i < n_sample; i++) {
+		_doc_map_measure (document, i, &size);
+		g_array_append_val (sizes, size);
+		estimate.width += size.width / n_sample;
+		estimate.height += size.height / n_sample;
+	}
 
-	if (!priv->document) {
-		g_print ("%s\n", priv->error->message);
-	} else {
-		priv->doc_map = _doc_map_init (priv->document);
+	GPtrArray *doc_map = g_ptr_array_new_full (n_pages, _doc_map_free_func);
+
+	for (gint i = 0; i < n_pages; i++) {
+		GspdfDocMap *map = g_malloc0 (sizeof (GspdfDocMap));
+		*map = (i < n_sample) ? g_array_index (sizes, GspdfDocMap, i) : estimate;
+		g_ptr_array_add (doc_map, map);
+	}
+
+	g_mutex_lock (&priv->mutex);
+
+	if (!_is_current (priv, generation)) {
+		g_mutex_unlock (&priv->mutex);
+		g_ptr_array_unref (doc_map);
+		g_array_unref (sizes);
+		g_object_unref (document);
+		g_free (uri);
+		return FALSE;
+	}
+
+	priv->document = g_object_ref (document);
+	priv->doc_map = doc_map;
+	priv->sizes = sizes;
+	priv->applied = sizes->len;
+
+	g_mutex_unlock (&priv->mutex);
+
+	// the document can be shown from here on
+	gspdf_task_notify_progress (task);
+
+	// the copies of the file the workers share are opened here rather
+	// than by whoever asks for a page first, the main thread included
+	if (!gspdf_task_get_cancel (task) && _is_current (priv, generation)) {
+		gspdf_document_open_handles (document);
 	}
 
+	gint64 last = g_get_monotonic_time ();
+	gint measured = n_sample;
+
+	for (gint i = n_sample; i < n_pages; i++) {
+		if (gspdf_task_get_cancel (task) || !_is_current (priv, generation)) {
+			break;
+		}
+
+		_doc_map_measure (document, i, &size);
+
+		g_mutex_lock (&priv->mutex);
+
+		if (_is_current (priv, generation)) {
+			g_array_append_val (priv->sizes, size);
+			measured++;
+		}
+
+		g_mutex_unlock (&priv->mutex);
+
+		if ((g_get_monotonic_time () - last) > GSPDF_TASK_LOADER_PROGRESS_INTERVAL) {
+			last = g_get_monotonic_time ();
+
+			if (_is_current (priv, generation)) {
+				gspdf_task_notify_progress (task);
+			}
+		}
+	}
+
+	// only a complete map is worth keeping, the next open skips measuring
+	if (has_id && (n_sample < n_pages) && (measured == n_pages)) {
+		g_mutex_lock (&priv->mutex);
+		GArray *copy = _is_current (priv, generation) ?
+			g_array_ref (priv->sizes) : NULL;
+		g_mutex_unlock (&priv->mutex);
+
+		if (copy) {
+			gspdf_sidecar_save (
+				GSPDF_TASK_LOADER_SIDECAR,
+				GSPDF_TASK_LOADER_SIDECAR_VERSION,
+				uri,
+				&file_id,
+				copy->data,
+				copy->len * sizeof (GspdfDocMap)
+			);
+			g_array_unref (copy);
+		}
+	}
+
+	g_object_unref (document);
+	g_free (uri);
+
 	return FALSE;
 }
 
@@ -135,6 +275,12 @@ gspdf_task_loader_dispose (GObject *object)
 
 	if (priv->doc_map) {
 		g_ptr_array_unref (priv->doc_map);
+		priv->doc_map = NULL;
+	}
+
+	if (priv->sizes) {
+		g_array_unref (priv->sizes);
+		priv->sizes = NULL;
 	}
 
 	G_OBJECT_CLASS (gspdf_task_loader_parent_class)->dispose (object);
@@ -143,13 +289,21 @@ gspdf_task_loader_dispose (GObject *object)
 static void
 gspdf_task_loader_finalize (GObject *object)
 {
+	GspdfTaskLoaderPrivate *priv = gspdf_task_loader_get_instance_private (
+		GSPDF_TASK_LOADER (object)
+	);
+
+	g_mutex_clear (&priv->mutex);
+
 	G_OBJECT_CLASS (gspdf_task_loader_parent_class)->finalize (object);
 }
 
 static void
 gspdf_task_loader_init (GspdfTaskLoader *task)
 {
+	GspdfTaskLoaderPrivate *priv = gspdf_task_loader_get_instance_private (task);
 
+	g_mutex_init (&priv->mutex);
 }
 
 static void
@@ -169,6 +323,7 @@ gspdf_task_loader_new (void)
 	return g_object_new (GSPDF_TYPE_TASK_LOADER, NULL);
 }
 
+// also stops a run in progress for the previous document
 void
 gspdf_task_loader_set (GspdfTaskLoader *task,
 	                     const gchar     *uri,
@@ -180,6 +335,10 @@ gspdf_task_loader_set (GspdfTaskLoader *task,
 
 	GspdfTaskLoaderPrivate *priv = gspdf_task_loader_get_instance_private (task);
 
+	g_mutex_lock (&priv->mutex);
+
+	g_atomic_int_inc (&priv->generation);
+
 	if (priv->document) {
 		g_object_unref (priv->document);
 		priv->document = NULL;
@@ -200,8 +359,21 @@ gspdf_task_loader_set (GspdfTaskLoader *task,
 		priv->password = NULL;
 	}
 
+	if (priv->doc_map) {
+		g_ptr_array_unref (priv->doc_map);
+		priv->doc_map = NULL;
+	}
+
+	if (priv->sizes) {
+		g_array_unref (priv->sizes);
+		priv->sizes = NULL;
+	}
+
+	priv->applied = 0;
 	priv->uri = g_strdup (uri);
 	priv->password = g_strdup (password);
+
+	g_mutex_unlock (&priv->mutex);
 }
 
 void
@@ -268,11 +440,11 @@ gspdf_task_loader_get_document (GspdfTaskLoader *task)
 
 	GspdfTaskLoaderPrivate *priv = gspdf_task_loader_get_instance_private (task);
 
-	g_return_val_if_fail (priv->document != NULL, NULL);
+	g_mutex_lock (&priv->mutex);
+	GspdfDocument *ret = priv->document ? g_object_ref (priv->document) : NULL;
+	g_mutex_unlock (&priv->mutex);
 
-	g_object_ref (priv->document);
-
-	return priv->document;
+	return ret;
 }
 
 GPtrArray *
@@ -283,11 +455,55 @@ gspdf_task_loader_get_document_map (GspdfTaskLoader *task)
 
 	GspdfTaskLoaderPrivate *priv = gspdf_task_loader_get_instance_private (task);
 
-	g_return_val_if_fail (priv->doc_map != NULL, NULL);
+	g_mutex_lock (&priv->mutex);
+	GPtrArray *ret = priv->doc_map ? g_ptr_array_ref (priv->doc_map) : NULL;
+	g_mutex_unlock (&priv->mutex);
+
+	return ret;
+}
+
+// copies the sizes measured since the last call into the document map,
+// from the main thread. start and end are the range of pages changed.
+gboolean
+gspdf_task_loader_update_document_map (GspdfTaskLoader *task,
+	                                     gint            *start,
+	                                     gint            *end)
+{
+	g_return_val_if_fail (task != NULL, FALSE);
+	g_return_val_if_fail (GSPDF_IS_TASK_LOADER (task), FALSE);
+
+	GspdfTaskLoaderPrivate *priv = gspdf_task_loader_get_instance_private (task);
+	gint s = -1, e = -1;
+
+	g_mutex_lock (&priv->mutex);
+
+	if (priv->doc_map && priv->sizes) {
+		for (guint i = priv->applied; i < priv->sizes->len; i++) {
+			GspdfDocMap *map = (GspdfDocMap*) g_ptr_array_index (priv->doc_map, i);
+			const GspdfDocMap *size = &g_array_index (priv->sizes, GspdfDocMap, i);
+
+			if ((map->width == size->width) && (map->height == size->height)) {
+				continue;
+			}
+
+			*map = *size;
+
+			if (s < 0) {
+				s = (gint) i;
+			}
+
+			e = (gint) i;
+		}
 
-	g_ptr_array_ref (priv->doc_map);
+		priv->applied = priv->sizes->len;
+	}
+
+	g_mutex_unlock (&priv->mutex);
 
-	return priv->doc_map;
+	if (start) { *start = s; }
+	if (end) { *end = e; }
+
+	return s >= 0;
 }
 
 GError *
@@ -298,11 +514,11 @@ gspdf_task_loader_get_gerror (GspdfTaskLoader *task)
 
 	GspdfTaskLoaderPrivate *priv = gspdf_task_loader_get_instance_private (task);
 
-	if (!priv->error) {
-		return NULL;
-	}
+	g_mutex_lock (&priv->mutex);
+	GError *ret = priv->error ? g_error_copy (priv->error) : NULL;
+	g_mutex_unlock (&priv->mutex);
 
-	return g_error_copy (priv->error);
+	return ret;
 }
 
 /**
@@ -312,10 +528,13 @@ gspdf_task_loader_get_gerror (GspdfTaskLoader *task)
 typedef struct {
 	GspdfDocument     *document;
 	GspdfDocumentPage *page;
-	GdkPixbuf         *pixbuf;
+	cairo_surface_t   *surface;
 	gint               index;
 	gdouble            scale;
-	GList             *text_mapping;
+
+	// only this part of the page is rendered when set
+	gboolean           has_region;
+	GspdfRectangle     region;
 } GspdfTaskRenderPrivate;
 
 struct _GspdfTaskRender {
@@ -328,12 +547,6 @@ G_DEFINE_TYPE_WITH_PRIVATE (
 	GSPDF_TYPE_TASK
 )
 
-static void
-_list_rectangle_free_func (gpointer data)
-{
-	g_free ((GspdfRectangle*)data);
-}
-
 static gboolean
 gspdf_task_render_run (GspdfTask *task)
 {
@@ -351,34 +564,30 @@ gspdf_task_render_run (GspdfTask *task)
 
 	g_return_val_if_fail (priv->page != NULL, FALSE);
 
-	if (priv->pixbuf) {
-		g_object_unref (priv->pixbuf);
-		priv->pixbuf = NULL;
+	// the page may have left the visible range while we were queued
+	if (gspdf_task_get_cancel (task)) {
+		return FALSE;
 	}
 
-	priv->pixbuf = gspdf_document_page_render (
-		priv->page,
-		priv->scale,
-		priv->scale
-	);
-
-	if (priv->text_mapping) {
-		g_list_free_full (priv->text_mapping, _list_rectangle_free_func);
-		priv->text_mapping = NULL;
+	if (priv->surface) {
+		cairo_surface_destroy (priv->surface);
+		priv->surface = NULL;
 	}
 
-	const GspdfRectangle rect = {
-		0,
-		0,
-		gspdf_document_page_get_width (priv->page),
-		gspdf_document_page_get_height (priv->page)
-	};
-
-	priv->text_mapping = gspdf_document_page_get_selected_region (
-		priv->page,
-		GSPDF_SELECTION_LINE,
-		&rect
-	);
+	if (priv->has_region) {
+		priv->surface = gspdf_document_page_render_area (
+			priv->page,
+			priv->scale,
+			priv->scale,
+			&priv->region
+		);
+	} else {
+		priv->surface = gspdf_document_page_render (
+			priv->page,
+			priv->scale,
+			priv->scale
+		);
+	}
 
 	return FALSE;
 }
@@ -401,14 +610,9 @@ gspdf_task_render_dispose (GObject *object)
 		priv->page = NULL;
 	}
 
-	if (priv->pixbuf) {
-		g_object_unref (priv->pixbuf);
-		priv->pixbuf = NULL;
-	}
-
-	if (priv->text_mapping) {
-		g_list_free_full (priv->text_mapping, _list_rectangle_free_func);
-		priv->text_mapping = NULL;
+	if (priv->surface) {
+		cairo_surface_destroy (priv->surface);
+		priv->surface = NULL;
 	}
 
 	G_OBJECT_CLASS (gspdf_task_loader_parent_class)->dispose (object);
@@ -423,7 +627,6 @@ gspdf_task_render_finalize (GObject *object)
 static void
 gspdf_task_render_init (GspdfTaskRender *task)
 {
-
 }
 
 static void
@@ -467,23 +670,36 @@ gspdf_task_render_set (GspdfTaskRender *task,
 		priv->page = NULL;
 	}
 
-	if (priv->pixbuf) {
-		g_object_unref (priv->pixbuf);
-		priv->pixbuf = NULL;
-	}
-
-	if (priv->text_mapping) {
-		g_list_free_full (priv->text_mapping, _list_rectangle_free_func);
-		priv->text_mapping = NULL;
+	if (priv->surface) {
+		cairo_surface_destroy (priv->surface);
+		priv->surface = NULL;
 	}
 
 	priv->index = index;
 	priv->scale = scale;
 	priv->document = doc;
+	priv->has_region = FALSE;
 
 	g_object_ref (priv->document);
 }
 
+// region is in pixels of the page at the task's scale
+void
+gspdf_task_render_set_region (GspdfTaskRender      *task,
+	                            const GspdfRectangle *region)
+{
+	g_return_if_fail (task != NULL);
+	g_return_if_fail (GSPDF_IS_TASK_RENDER (task));
+
+	GspdfTaskRenderPrivate *priv = gspdf_task_render_get_instance_private (task);
+
+	priv->has_region = (region != NULL);
+
+	if (region) {
+		priv->region = *region;
+	}
+}
+
 gint
 gspdf_task_render_get_index (GspdfTaskRender *task)
 {
@@ -495,28 +711,710 @@ gspdf_task_render_get_index (GspdfTaskRender *task)
 	return priv->index;
 }
 
-GdkPixbuf *
-gspdf_task_render_get_pixbuf (GspdfTaskRender *task)
+cairo_surface_t *
+gspdf_task_render_get_surface (GspdfTaskRender *task)
 {
 	g_return_val_if_fail (task != NULL, NULL);
 	g_return_val_if_fail (GSPDF_IS_TASK_RENDER (task), NULL);
 
 	GspdfTaskRenderPrivate *priv = gspdf_task_render_get_instance_private (task);
 
-	g_return_val_if_fail (priv->pixbuf != NULL, NULL);
+	g_return_val_if_fail (priv->surface != NULL, NULL);
+
+	return cairo_surface_reference (priv->surface);
+}
+
+// swaps the render for an equivalent surface, once the task is done
+void
+gspdf_task_render_set_surface (GspdfTaskRender *task,
+	                             cairo_surface_t *surface)
+{
+	g_return_if_fail (task != NULL);
+	g_return_if_fail (GSPDF_IS_TASK_RENDER (task));
+	g_return_if_fail (surface != NULL);
+
+	GspdfTaskRenderPrivate *priv = gspdf_task_render_get_instance_private (task);
+
+	cairo_surface_reference (surface);
 
-	g_object_ref (priv->pixbuf);
+	if (priv->surface) {
+		cairo_surface_destroy (priv->surface);
+	}
 
-	return priv->pixbuf;
+	priv->surface = surface;
 }
 
+/**
+ * GspdfTaskText
+ */
+
+typedef struct {
+	GspdfDocument   *document;
+	gint             index;
+
+	// GspdfRectangle of every line of text, in page units so that it
+	// holds at any scale
+	GList           *text_mapping;
+	// the lines and the links of the page, for hit testing
+	GspdfHitIndex   *hit_index;
+	// every character and its box, selections are computed from it
+	GspdfTextLayout *text_layout;
+
+	// text_mapping and hit_index are published as soon as they are
+	// built, links work before the slower text layout is done
+	gint             mapping_ready;
+} GspdfTaskTextPrivate;
+
+struct _GspdfTaskText {
+	GspdfTask parent;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (
+	GspdfTaskText,
+	gspdf_task_text,
+	GSPDF_TYPE_TASK
+)
+
+static void
+_list_rectangle_free_func (gpointer data)
+{
+	g_free ((GspdfRectangle*)data);
+}
+
+static gboolean
+gspdf_task_text_run (GspdfTask *task)
+{
+	GspdfTaskText *task_text = GSPDF_TASK_TEXT (task);
+	GspdfTaskTextPrivate *priv = gspdf_task_text_get_instance_private (task_text);
+
+	g_return_val_if_fail (priv->document != NULL, FALSE);
+
+	if (gspdf_task_get_cancel (task)) {
+		return FALSE;
+	}
+
+	GspdfDocumentPage *page = gspdf_document_get_page (priv->document, priv->index);
+
+	g_return_val_if_fail (page != NULL, FALSE);
+
+	g_atomic_int_set (&priv->mapping_ready, FALSE);
+
+	if (priv->text_mapping) {
+		g_list_free_full (priv->text_mapping, _list_rectangle_free_func);
+		priv->text_mapping = NULL;
+	}
+
+	if (priv->hit_index) {
+		gspdf_hit_index_free (priv->hit_index);
+		priv->hit_index = NULL;
+	}
+
+	if (priv->text_layout) {
+		gspdf_text_layout_free (priv->text_layout);
+		priv->text_layout = NULL;
+	}
+
+	const GspdfRectangle rect = {
+		0,
+		0,
+		gspdf_document_page_get_width (page),
+		gspdf_document_page_get_height (page)
+	};
+
+	priv->text_mapping = gspdf_document_page_get_selected_region (
+		page,
+		GSPDF_SELECTION_LINE,
+		&rect
+	);
+
+	priv->hit_index = gspdf_hit_index_new (
+		rect.width,
+		rect.height,
+		gspdf_document_page_get_link_mapping (page),
+		priv->text_mapping
+	);
+
+	g_atomic_int_set (&priv->mapping_ready, TRUE);
+
+	if (!gspdf_task_get_cancel (task)) {
+		priv->text_layout = gspdf_text_layout_new_from_page (page);
+	}
+
+	g_object_unref (page);
+
+	return FALSE;
+}
+
+static void
+gspdf_task_text_dispose (GObject *object)
+{
+	GspdfTaskText *task_text = GSPDF_TASK_TEXT (object);
+	GspdfTaskTextPrivate *priv = gspdf_task_text_get_instance_private (task_text);
+
+	if (priv->document) {
+		g_object_unref (priv->document);
+		priv->document = NULL;
+	}
+
+	if (priv->text_mapping) {
+		g_list_free_full (priv->text_mapping, _list_rectangle_free_func);
+		priv->text_mapping = NULL;
+	}
+
+	if (priv->hit_index) {
+		gspdf_hit_index_free (priv->hit_index);
+		priv->hit_index = NULL;
+	}
+
+	if (priv->text_layout) {
+		gspdf_text_layout_free (priv->text_layout);
+		priv->text_layout = NULL;
+	}
+
+	G_OBJECT_CLASS (gspdf_task_text_parent_class)->dispose (object);
+}
+
+static void
+gspdf_task_text_finalize (GObject *object)
+{
+	G_OBJECT_CLASS (gspdf_task_text_parent_class)->finalize (object);
+}
+
+static void
+gspdf_task_text_init (GspdfTaskText *task)
+{
+}
+
+static void
+gspdf_task_text_class_init (GspdfTaskTextClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	GspdfTaskClass *task_class = GSPDF_TASK_CLASS (klass);
+
+	object_class->dispose = gspdf_task_text_dispose;
+	object_class->finalize = gspdf_task_text_finalize;
+
+	task_class->run = gspdf_task_text_run;
+}
+
+GspdfTask *
+gspdf_task_text_new (void)
+{
+	return g_object_new (GSPDF_TYPE_TASK_TEXT, NULL);
+}
+
+void
+gspdf_task_text_set (GspdfTaskText *task,
+	                   GspdfDocument *doc,
+	                   gint           index)
+{
+	g_return_if_fail (task != NULL);
+	g_return_if_fail (GSPDF_IS_TASK_TEXT (task));
+	g_return_if_fail (doc != NULL);
+	g_return_if_fail (GSPDF_IS_DOCUMENT (doc));
+
+	GspdfTaskTextPrivate *priv = gspdf_task_text_get_instance_private (task);
+
+	if (priv->document) {
+		g_object_unref (priv->document);
+		priv->document = NULL;
+	}
+
+	if (priv->text_mapping) {
+		g_list_free_full (priv->text_mapping, _list_rectangle_free_func);
+		priv->text_mapping = NULL;
+	}
+
+	if (priv->hit_index) {
+		gspdf_hit_index_free (priv->hit_index);
+		priv->hit_index = NULL;
+	}
+
+	if (priv->text_layout) {
+		gspdf_text_layout_free (priv->text_layout);
+		priv->text_layout = NULL;
+	}
+
+	priv->index = index;
+	priv->document = g_object_ref (doc);
+	priv->mapping_ready = FALSE;
+}
+
+gint
+gspdf_task_text_get_index (GspdfTaskText *task)
+{
+	g_return_val_if_fail (task != NULL, -1);
+	g_return_val_if_fail (GSPDF_IS_TASK_TEXT (task), -1);
+
+	GspdfTaskTextPrivate *priv = gspdf_task_text_get_instance_private (task);
+
+	return priv->index;
+}
+
+// NULL until the run has built it, which may be before the task is done
 GList *
-gspdf_task_render_get_text_mapping (GspdfTaskRender *task)
+gspdf_task_text_get_text_mapping (GspdfTaskText *task)
 {
 	g_return_val_if_fail (task != NULL, NULL);
-	g_return_val_if_fail (GSPDF_IS_TASK_RENDER (task), NULL);
+	g_return_val_if_fail (GSPDF_IS_TASK_TEXT (task), NULL);
 
-	GspdfTaskRenderPrivate *priv = gspdf_task_render_get_instance_private (task);
+	GspdfTaskTextPrivate *priv = gspdf_task_text_get_instance_private (task);
+
+	if (!g_atomic_int_get (&priv->mapping_ready)) {
+		return NULL;
+	}
 
 	return priv->text_mapping;
 }
+
+// NULL until the run has built it, which may be before the task is done
+GspdfHitIndex *
+gspdf_task_text_get_hit_index (GspdfTaskText *task)
+{
+	g_return_val_if_fail (task != NULL, NULL);
+	g_return_val_if_fail (GSPDF_IS_TASK_TEXT (task), NULL);
+
+	GspdfTaskTextPrivate *priv = gspdf_task_text_get_instance_private (task);
+
+	if (!g_atomic_int_get (&priv->mapping_ready)) {
+		return NULL;
+	}
+
+	return priv->hit_index;
+}
+
+GspdfTextLayout *
+gspdf_task_text_get_text_layout (GspdfTaskText *task)
+{
+	g_return_val_if_fail (task != NULL, NULL);
+	g_return_val_if_fail (GSPDF_IS_TASK_TEXT (task), NULL);
+
+	GspdfTaskTextPrivate *priv = gspdf_task_text_get_instance_private (task);
+
+	return priv->text_layout;
+}
+
+/**
+ * GspdfTaskFind
+ */
+
+typedef struct {
+	gint   index;
+	GList *rects;
+} GspdfTaskFindResult;
+
+typedef struct {
+	GspdfDocument  *document;
+	gchar          *text;
+	GspdfFindFlags  options;
+	// the gint pages to search, in search order
+	GArray         *pages;
+
+	// GspdfTaskFindResult of the pages searched so far, in page order,
+	// filled by the worker and drained by the main thread
+	GMutex          mutex;
+	GQueue          results;
+} GspdfTaskFindPrivate;
+
+struct _GspdfTaskFind {
+	GspdfTask parent;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (
+	GspdfTaskFind,
+	gspdf_task_find,
+	GSPDF_TYPE_TASK
+)
+
+static void
+_task_find_result_free_func (gpointer data)
+{
+	GspdfTaskFindResult *result = (GspdfTaskFindResult*) data;
+
+	g_list_free_full (result->rects, _list_rectangle_free_func);
+	g_free (result);
+}
+
+static gboolean
+gspdf_task_find_run (GspdfTask *task)
+{
+	GspdfTaskFind *task_find = GSPDF_TASK_FIND (task);
+	GspdfTaskFindPrivate *priv = gspdf_task_find_get_instance_private (task_find);
+
+	g_return_val_if_fail (priv->document != NULL, FALSE);
+	g_return_val_if_fail (priv->text != NULL, FALSE);
+
+	for (guint n = 0; n < priv->pages->len; n++) {
+		// the query changed, the rest of the chunk is of no use
+		if (gspdf_task_get_cancel (task)) {
+			break;
+		}
+
+		const gint i = g_array_index (priv->pages, gint, n);
+		GspdfDocumentPage *page = gspdf_document_get_page (priv->document, i);
+		GList *rects = gspdf_document_page_find_text (page, priv->text, priv->options);
+
+		g_object_unref (page);
+
+		if (!rects) {
+			continue;
+		}
+
+		GspdfTaskFindResult *result = g_malloc (sizeof (GspdfTaskFindResult));
+		result->index = i;
+		result->rects = rects;
+
+		g_mutex_lock (&priv->mutex);
+		g_queue_push_tail (&priv->results, result);
+		g_mutex_unlock (&priv->mutex);
+
+		// reported after every page with a hit
+		gspdf_task_notify_progress (task);
+	}
+
+	return FALSE;
+}
+
+static void
+gspdf_task_find_dispose (GObject *object)
+{
+	GspdfTaskFind *task_find = GSPDF_TASK_FIND (object);
+	GspdfTaskFindPrivate *priv = gspdf_task_find_get_instance_private (task_find);
+
+	if (priv->document) {
+		g_object_unref (priv->document);
+		priv->document = NULL;
+	}
+
+	gpointer result = NULL;
+
+	while ((result = g_queue_pop_head (&priv->results)) != NULL) {
+		_task_find_result_free_func (result);
+	}
+
+	G_OBJECT_CLASS (gspdf_task_find_parent_class)->dispose (object);
+}
+
+static void
+gspdf_task_find_finalize (GObject *object)
+{
+	GspdfTaskFind *task_find = GSPDF_TASK_FIND (object);
+	GspdfTaskFindPrivate *priv = gspdf_task_find_get_instance_private (task_find);
+
+	g_free (priv->text);
+	g_array_unref (priv->pages);
+	g_mutex_clear (&priv->mutex);
+
+	G_OBJECT_CLASS (gspdf_task_find_parent_class)->finalize (object);
+}
+
+static void
+gspdf_task_find_init (GspdfTaskFind *task)
+{
+	GspdfTaskFindPrivate *priv = gspdf_task_find_get_instance_private (task);
+
+	g_mutex_init (&priv->mutex);
+	g_queue_init (&priv->results);
+	priv->pages = g_array_new (FALSE, FALSE, sizeof (gint));
+}
+
+static void
+gspdf_task_find_class_init (GspdfTaskFindClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	GspdfTaskClass *task_class = GSPDF_TASK_CLASS (klass);
+
+	object_class->dispose = gspdf_task_find_dispose;
+	object_class->finalize = gspdf_task_find_finalize;
+
+	task_class->run = gspdf_task_find_run;
+}
+
+GspdfTask *
+gspdf_task_find_new (void)
+{
+	return g_object_new (GSPDF_TYPE_TASK_FIND, NULL);
+}
+
+// searches n_pages pages from start on
+void
+gspdf_task_find_set (GspdfTaskFind  *task,
+	                   GspdfDocument  *doc,
+	                   const gchar    *text,
+	                   GspdfFindFlags  options,
+	                   gint            start,
+	                   gint            n_pages)
+{
+	g_return_if_fail (task != NULL);
+	g_return_if_fail (GSPDF_IS_TASK_FIND (task));
+	g_return_if_fail (doc != NULL);
+	g_return_if_fail (GSPDF_IS_DOCUMENT (doc));
+	g_return_if_fail (text != NULL);
+
+	GspdfTaskFindPrivate *priv = gspdf_task_find_get_instance_private (task);
+
+	if (priv->document) {
+		g_object_unref (priv->document);
+	}
+
+	g_free (priv->text);
+
+	priv->document = g_object_ref (doc);
+	priv->text = g_strdup (text);
+	priv->options = options;
+
+	g_array_set_size (priv->pages, 0);
+
+	for (gint i = start; i < start + n_pages; i++) {
+		g_array_append_val (priv->pages, i);
+	}
+}
+
+// searches the n_pages pages of pages, in that order
+void
+gspdf_task_find_set_pages (GspdfTaskFind  *task,
+	                         GspdfDocument  *doc,
+	                         const gchar    *text,
+	                         GspdfFindFlags  options,
+	                         const gint     *pages,
+	                         guint           n_pages)
+{
+	g_return_if_fail (task != NULL);
+	g_return_if_fail (GSPDF_IS_TASK_FIND (task));
+	g_return_if_fail ((pages != NULL) || (n_pages == 0));
+
+	GspdfTaskFindPrivate *priv = gspdf_task_find_get_instance_private (task);
+
+	gspdf_task_find_set (task, doc, text, options, 0, 0);
+	g_array_append_vals (priv->pages, pages, n_pages);
+}
+
+// the GspdfRectangle hits of the next page found, in page units, or NULL
+// when nothing new was found since the last call
+GList *
+gspdf_task_find_pop_result (GspdfTaskFind *task,
+	                          gint          *index)
+{
+	g_return_val_if_fail (task != NULL, NULL);
+	g_return_val_if_fail (GSPDF_IS_TASK_FIND (task), NULL);
+
+	GspdfTaskFindPrivate *priv = gspdf_task_find_get_instance_private (task);
+
+	g_mutex_lock (&priv->mutex);
+	GspdfTaskFindResult *result = g_queue_pop_head (&priv->results);
+	g_mutex_unlock (&priv->mutex);
+
+	if (!result) {
+		return NULL;
+	}
+
+	GList *ret = result->rects;
+
+	if (index) {
+		*index = result->index;
+	}
+
+	g_free (result);
+
+	return ret;
+}
+
+/**
+ * GspdfTaskIndex
+ */
+
+// sidecar kind of the text index of a document
+#define GSPDF_TASK_INDEX_SIDECAR "text-index"
+// bumped whenever the folding of words changes
+#define GSPDF_TASK_INDEX_SIDECAR_VERSION 2
+
+typedef struct {
+	GspdfDocument  *document;
+	gchar          *uri;
+
+	// the words of every page, set once the task is finished
+	GspdfTextIndex *text_index;
+} GspdfTaskIndexPrivate;
+
+struct _GspdfTaskIndex {
+	GspdfTask parent;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (
+	GspdfTaskIndex,
+	gspdf_task_index,
+	GSPDF_TYPE_TASK
+)
+
+static gboolean
+gspdf_task_index_run (GspdfTask *task)
+{
+	GspdfTaskIndex *task_index = GSPDF_TASK_INDEX (task);
+	GspdfTaskIndexPrivate *priv = gspdf_task_index_get_instance_private (task_index);
+
+	g_return_val_if_fail (priv->document != NULL, FALSE);
+	g_return_val_if_fail (priv->uri != NULL, FALSE);
+
+	if (priv->text_index) {
+		return FALSE;
+	}
+
+	const gint n_pages = gspdf_document_get_n_pages (priv->document);
+
+	// a document indexed before has its index on disk, nothing to extract
+	GspdfFileId file_id;
+	const gboolean has_id = gspdf_file_id_query (priv->uri, &file_id);
+	GBytes *stored = (has_id) ?
+		gspdf_sidecar_load (
+			GSPDF_TASK_INDEX_SIDECAR,
+			GSPDF_TASK_INDEX_SIDECAR_VERSION,
+			priv->uri,
+			&file_id
+		) : NULL;
+
+	if (stored) {
+		GspdfTextIndex *text_index = gspdf_text_index_new_from_bytes (stored);
+		g_bytes_unref (stored);
+
+		if (text_index && (gspdf_text_index_get_n_pages (text_index) == n_pages)) {
+			priv->text_index = text_index;
+			return FALSE;
+		}
+
+		if (text_index) {
+			gspdf_text_index_free (text_index);
+		}
+	}
+
+	GspdfTextIndex *text_index = gspdf_text_index_new (n_pages);
+
+	for (gint i = 0; i < n_pages; i++) {
+		// the document was closed, a partial index is of no use
+		if (gspdf_task_get_cancel (task)) {
+			gspdf_text_index_free (text_index);
+			return FALSE;
+		}
+
+		GspdfDocumentPage *page = gspdf_document_get_page (priv->document, i);
+		gchar *text = gspdf_document_page_get_text (page);
+
+		g_object_unref (page);
+
+		if (text) {
+			gspdf_text_index_add_page (text_index, i, text);
+			g_free (text);
+		}
+	}
+
+	if (has_id) {
+		GBytes *bytes = gspdf_text_index_to_bytes (text_index);
+
+		gspdf_sidecar_save (
+			GSPDF_TASK_INDEX_SIDECAR,
+			GSPDF_TASK_INDEX_SIDECAR_VERSION,
+			priv->uri,
+			&file_id,
+			g_bytes_get_data (bytes, NULL),
+			g_bytes_get_size (bytes)
+		);
+		g_bytes_unref (bytes);
+	}
+
+	priv->text_index = text_index;
+
+	return FALSE;
+}
+
+static void
+gspdf_task_index_dispose (GObject *object)
+{
+	GspdfTaskIndex *task_index = GSPDF_TASK_INDEX (object);
+	GspdfTaskIndexPrivate *priv = gspdf_task_index_get_instance_private (task_index);
+
+	if (priv->document) {
+		g_object_unref (priv->document);
+		priv->document = NULL;
+	}
+
+	if (priv->text_index) {
+		gspdf_text_index_free (priv->text_index);
+		priv->text_index = NULL;
+	}
+
+	G_OBJECT_CLASS (gspdf_task_index_parent_class)->dispose (object);
+}
+
+static void
+gspdf_task_index_finalize (GObject *object)
+{
+	GspdfTaskIndex *task_index = GSPDF_TASK_INDEX (object);
+	GspdfTaskIndexPrivate *priv = gspdf_task_index_get_instance_private (task_index);
+
+	g_free (priv->uri);
+
+	G_OBJECT_CLASS (gspdf_task_index_parent_class)->finalize (object);
+}
+
+static void
+gspdf_task_index_init (GspdfTaskIndex *task)
+{
+}
+
+static void
+gspdf_task_index_class_init (GspdfTaskIndexClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	GspdfTaskClass *task_class = GSPDF_TASK_CLASS (klass);
+
+	object_class->dispose = gspdf_task_index_dispose;
+	object_class->finalize = gspdf_task_index_finalize;
+
+	task_class->run = gspdf_task_index_run;
+}
+
+GspdfTask *
+gspdf_task_index_new (void)
+{
+	return g_object_new (GSPDF_TYPE_TASK_INDEX, NULL);
+}
+
+// uri is where doc was opened from, the index is stored for it
+void
+gspdf_task_index_set (GspdfTaskIndex *task,
+	                    GspdfDocument  *doc,
+	                    const gchar    *uri)
+{
+	g_return_if_fail (task != NULL);
+	g_return_if_fail (GSPDF_IS_TASK_INDEX (task));
+	g_return_if_fail (doc != NULL);
+	g_return_if_fail (GSPDF_IS_DOCUMENT (doc));
+	g_return_if_fail (uri != NULL);
+
+	GspdfTaskIndexPrivate *priv = gspdf_task_index_get_instance_private (task);
+
+	if (priv->document) {
+		g_object_unref (priv->document);
+	}
+
+	if (priv->text_index) {
+		gspdf_text_index_free (priv->text_index);
+		priv->text_index = NULL;
+	}
+
+	g_free (priv->uri);
+
+	priv->document = g_object_ref (doc);
+	priv->uri = g_strdup (uri);
+}
+
+// owned by the task, NULL until it is finished
+GspdfTextIndex *
+gspdf_task_index_get_text_index (GspdfTaskIndex *task)
+{
+	g_return_val_if_fail (task != NULL, NULL);
+	g_return_val_if_fail (GSPDF_IS_TASK_INDEX (task), NULL);
+
+	GspdfTaskIndexPrivate *priv = gspdf_task_index_get_instance_private (task);
+
+	return priv->text_index;
+}
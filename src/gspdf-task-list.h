@@ -24,6 +24,18 @@
 #include "gspdf-document/gspdf-doc.h"
 #endif
 
+#ifndef GSPDF_HIT_INDEX_H
+#include "gspdf-hit-index.h"
+#endif
+
+#ifndef GSPDF_TEXT_LAYOUT_H
+#include "gspdf-text-layout.h"
+#endif
+
+#ifndef GSPDF_TEXT_INDEX_H
+#include "gspdf-text-index.h"
+#endif
+
 G_BEGIN_DECLS
 
 typedef struct {
@@ -72,6 +84,11 @@ gspdf_task_loader_get_document (GspdfTaskLoader *task);
 GPtrArray *
 gspdf_task_loader_get_document_map (GspdfTaskLoader *task);
 
+gboolean
+gspdf_task_loader_update_document_map (GspdfTaskLoader *task,
+	                                     gint            *start,
+	                                     gint            *end);
+
 GError *
 gspdf_task_loader_get_gerror (GspdfTaskLoader *task);
 
@@ -97,15 +114,112 @@ gspdf_task_render_set (GspdfTaskRender *task,
 											 gint index,
 											 gdouble scale);
 
+void
+gspdf_task_render_set_region (GspdfTaskRender      *task,
+	                            const GspdfRectangle *region);
+
 gint
 gspdf_task_render_get_index (GspdfTaskRender *task);
 
-GdkPixbuf *
-gspdf_task_render_get_pixbuf (GspdfTaskRender *task);
+cairo_surface_t *
+gspdf_task_render_get_surface (GspdfTaskRender *task);
+
+void
+gspdf_task_render_set_surface (GspdfTaskRender *task,
+	                             cairo_surface_t *surface);
+
+/**
+ * GspdfTaskText
+ */
+
+#define GSPDF_TYPE_TASK_TEXT gspdf_task_text_get_type ()
+G_DECLARE_FINAL_TYPE (
+	GspdfTaskText,
+	gspdf_task_text,
+	GSPDF,
+	TASK_TEXT,
+	GspdfTask
+)
+
+GspdfTask *
+gspdf_task_text_new (void);
+
+void
+gspdf_task_text_set (GspdfTaskText *task,
+	                   GspdfDocument *doc,
+	                   gint           index);
+
+gint
+gspdf_task_text_get_index (GspdfTaskText *task);
 
 GList *
-gspdf_task_render_get_text_mapping (GspdfTaskRender *task);
+gspdf_task_text_get_text_mapping (GspdfTaskText *task);
+
+GspdfHitIndex *
+gspdf_task_text_get_hit_index (GspdfTaskText *task);
+
+GspdfTextLayout *
+gspdf_task_text_get_text_layout (GspdfTaskText *task);
+
+/**
+ * GspdfTaskFind
+ */
+
+#define GSPDF_TYPE_TASK_FIND gspdf_task_find_get_type ()
+G_DECLARE_FINAL_TYPE (
+	GspdfTaskFind,
+	gspdf_task_find,
+	GSPDF,
+	TASK_FIND,
+	GspdfTask
+)
+
+GspdfTask *
+gspdf_task_find_new (void);
+
+void
+gspdf_task_find_set (GspdfTaskFind  *task,
+	                   GspdfDocument  *doc,
+	                   const gchar    *text,
+	                   GspdfFindFlags  options,
+	                   gint            start,
+	                   gint            n_pages);
+
+void
+gspdf_task_find_set_pages (GspdfTaskFind  *task,
+	                         GspdfDocument  *doc,
+	                         const gchar    *text,
+	                         GspdfFindFlags  options,
+	                         const gint     *pages,
+	                         guint           n_pages);
+
+GList *
+gspdf_task_find_pop_result (GspdfTaskFind *task,
+	                          gint          *index);
+
+/**
+ * GspdfTaskIndex
+ */
+
+#define GSPDF_TYPE_TASK_INDEX gspdf_task_index_get_type ()
+G_DECLARE_FINAL_TYPE (
+	GspdfTaskIndex,
+	gspdf_task_index,
+	GSPDF,
+	TASK_INDEX,
+	GspdfTask
+)
+
+GspdfTask *
+gspdf_task_index_new (void);
+
+void
+gspdf_task_index_set (GspdfTaskIndex *task,
+	                    GspdfDocument  *doc,
+	                    const gchar    *uri);
 
+GspdfTextIndex *
+gspdf_task_index_get_text_index (GspdfTaskIndex *task);
 
 G_END_DECLS
 
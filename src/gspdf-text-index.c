@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 2017, Fajar Dwi Darmanto <fajardwidarm@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include "gspdf-text-index.h"
+
+#include <string.h>
+
+// an inverted index of the words of a document
+struct _GspdfTextIndex {
+	gint        n_pages;
+
+	// folded word -> GArray of the guint32 pages having it, ascending
+	GHashTable *terms;
+};
+
+static void
+_postings_free_func (gpointer data)
+{
+	g_array_unref ((GArray*) data);
+}
+
+// a word as it is indexed and looked up: compatibility forms like
+// ligatures and full width letters folded into their plain ones, then
+// casefolded, so both sides compare the same
+static gchar *
+_text_index_fold (const gchar *word,
+                  gssize       len)
+{
+	gchar *folded = g_utf8_casefold (word, len);
+	gchar *ret = g_utf8_normalize (folded, -1, G_NORMALIZE_ALL);
+
+	g_free (folded);
+
+	return ret;
+}
+
+// the folded runs of letters and digits of text
+static GPtrArray *
+_text_index_split (const gchar *text)
+{
+	GPtrArray *ret = g_ptr_array_new_with_free_func (g_free);
+
+	// composed first, a letter and its accent make one character
+	gchar *normalized = g_utf8_normalize (text, -1, G_NORMALIZE_ALL);
+
+	if (!normalized) {
+		return ret;
+	}
+
+	const gchar *p = normalized;
+	const gchar *start = NULL;
+
+	for (;;) {
+		const gunichar c = g_utf8_get_char (p);
+		const gboolean in_word = (c != 0) && g_unichar_isalnum (c);
+
+		if (in_word && !start) {
+			start = p;
+		} else if (!in_word && start) {
+			g_ptr_array_add (ret, _text_index_fold (start, p - start));
+			start = NULL;
+		}
+
+		if (c == 0) {
+			break;
+		}
+
+		p = g_utf8_next_char (p);
+	}
+
+	g_free (normalized);
+
+	return ret;
+}
+
+static GspdfTextIndex *
+_text_index_new (gint n_pages)
+{
+	GspdfTextIndex *ret = g_malloc0 (sizeof (GspdfTextIndex));
+
+	ret->n_pages = n_pages;
+	ret->terms = g_hash_table_new_full (
+		g_str_hash,
+		g_str_equal,
+		g_free,
+		_postings_free_func
+	);
+
+	return ret;
+}
+
+GspdfTextIndex *
+gspdf_text_index_new (gint n_pages)
+{
+	g_return_val_if_fail (n_pages >= 0, NULL);
+
+	return _text_index_new (n_pages);
+}
+
+void
+gspdf_text_index_free (GspdfTextIndex *index)
+{
+	g_return_if_fail (index != NULL);
+
+	g_hash_table_unref (index->terms);
+	g_free (index);
+}
+
+// pages are added in ascending order
+void
+gspdf_text_index_add_page (GspdfTextIndex *index,
+                           gint            page,
+                           const gchar    *text)
+{
+	g_return_if_fail (index != NULL);
+	g_return_if_fail ((page >= 0) && (page < index->n_pages));
+	g_return_if_fail (text != NULL);
+
+	GPtrArray *words = _text_index_split (text);
+
+	for (guint i = 0; i < words->len; i++) {
+		const gchar *word = g_ptr_array_index (words, i);
+		GArray *postings = g_hash_table_lookup (index->terms, word);
+
+		if (!postings) {
+			postings = g_array_new (FALSE, FALSE, sizeof (guint32));
+			g_hash_table_insert (index->terms, g_strdup (word), postings);
+		}
+
+		const guint32 value = (guint32) page;
+
+		if ((postings->len == 0) ||
+		    (g_array_index (postings, guint32, postings->len - 1) != value)) {
+			g_array_append_val (postings, value);
+		}
+	}
+
+	g_ptr_array_unref (words);
+}
+
+gint
+gspdf_text_index_get_n_pages (const GspdfTextIndex *index)
+{
+	g_return_val_if_fail (index != NULL, 0);
+
+	return index->n_pages;
+}
+
+// n_pages and n_terms, then for every term its length, its bytes, the
+// number of pages having it and those pages, all in host order
+GBytes *
+gspdf_text_index_to_bytes (const GspdfTextIndex *index)
+{
+	g_return_val_if_fail (index != NULL, NULL);
+
+	GByteArray *ret = g_byte_array_new ();
+	guint32 value = (guint32) index->n_pages;
+	GHashTableIter iter;
+	gpointer key = NULL, data = NULL;
+
+	g_byte_array_append (ret, (const guint8*) &value, sizeof (guint32));
+	value = g_hash_table_size (index->terms);
+	g_byte_array_append (ret, (const guint8*) &value, sizeof (guint32));
+
+	g_hash_table_iter_init (&iter, index->terms);
+
+	while (g_hash_table_iter_next (&iter, &key, &data)) {
+		GArray *postings = (GArray*) data;
+
+		value = strlen ((const gchar*) key);
+		g_byte_array_append (ret, (const guint8*) &value, sizeof (guint32));
+		g_byte_array_append (ret, (const guint8*) key, value);
+
+		value = postings->len;
+		g_byte_array_append (ret, (const guint8*) &value, sizeof (guint32));
+		g_byte_array_append (
+			ret,
+			(const guint8*) postings->data,
+			postings->len * sizeof (guint32)
+		);
+	}
+
+	return g_byte_array_free_to_bytes (ret);
+}
+
+static gboolean
+_bytes_read (const guint8 **p,
+             const guint8  *end,
+             gpointer       dest,
+             gsize          n)
+{
+	if ((gsize) (end - *p) < n) {
+		return FALSE;
+	}
+
+	memcpy (dest, *p, n);
+	*p += n;
+
+	return TRUE;
+}
+
+// NULL if bytes is not an index written by gspdf_text_index_to_bytes
+GspdfTextIndex *
+gspdf_text_index_new_from_bytes (GBytes *bytes)
+{
+	g_return_val_if_fail (bytes != NULL, NULL);
+
+	gsize size = 0;
+	const guint8 *p = g_bytes_get_data (bytes, &size);
+	const guint8 *end = p + size;
+	guint32 n_pages = 0, n_terms = 0;
+
+	if (!_bytes_read (&p, end, &n_pages, sizeof (guint32)) ||
+	    !_bytes_read (&p, end, &n_terms, sizeof (guint32)) ||
+	    (n_pages > G_MAXINT)) {
+		return NULL;
+	}
+
+	GspdfTextIndex *ret = _text_index_new ((gint) n_pages);
+
+	for (guint32 i = 0; i < n_terms; i++) {
+		guint32 len = 0, n_term_pages = 0;
+
+		if (!_bytes_read (&p, end, &len, sizeof (guint32)) ||
+		    ((gsize) (end - p) < len)) {
+			break;
+		}
+
+		gchar *term = g_strndup ((const gchar*) p, len);
+		p += len;
+
+		if (!_bytes_read (&p, end, &n_term_pages, sizeof (guint32)) ||
+		    (((gsize) (end - p) / sizeof (guint32)) < n_term_pages)) {
+			g_free (term);
+			break;
+		}
+
+		GArray *postings = g_array_sized_new (
+			FALSE,
+			FALSE,
+			sizeof (guint32),
+			n_term_pages
+		);
+
+		g_array_append_vals (postings, p, n_term_pages);
+		p += n_term_pages * sizeof (guint32);
+		g_hash_table_insert (ret->terms, term, postings);
+	}
+
+	if ((p != end) || (g_hash_table_size (ret->terms) != n_terms)) {
+		gspdf_text_index_free (ret);
+		return NULL;
+	}
+
+	return ret;
+}
+
+// a hit spans whole words in its middle, but its first word may end a
+// word of the page and its last may start one
+static gboolean
+_term_matches (const gchar *term,
+               const gchar *word,
+               guint        i,
+               guint        n)
+{
+	if (n == 1) {
+		return strstr (term, word) != NULL;
+	}
+
+	if (i == 0) {
+		return g_str_has_suffix (term, word);
+	}
+
+	if (i == (n - 1)) {
+		return g_str_has_prefix (term, word);
+	}
+
+	return g_str_equal (term, word);
+}
+
+static void
+_postings_mark (const GArray *postings,
+                gint          n_pages,
+                gboolean     *found)
+{
+	for (guint i = 0; i < postings->len; i++) {
+		const guint32 page = g_array_index (postings, guint32, i);
+
+		if (page < (guint32) n_pages) {
+			found[page] = TRUE;
+		}
+	}
+}
+
+// the ascending gint pages that may have a hit on text, whatever the
+// case, or NULL when text has no words to look up and every page has to
+// be searched
+GArray *
+gspdf_text_index_lookup (const GspdfTextIndex *index,
+                         const gchar          *text)
+{
+	g_return_val_if_fail (index != NULL, NULL);
+	g_return_val_if_fail (text != NULL, NULL);
+
+	GPtrArray *words = _text_index_split (text);
+
+	if (words->len == 0) {
+		g_ptr_array_unref (words);
+		return NULL;
+	}
+
+	// how many of the words each page has, a page is kept only if it
+	// has every one of them
+	guint *hits = g_malloc0 (MAX (index->n_pages, 1) * sizeof (guint));
+	gboolean *found = g_malloc (MAX (index->n_pages, 1) * sizeof (gboolean));
+
+	for (guint i = 0; i < words->len; i++) {
+		const gchar *word = g_ptr_array_index (words, i);
+
+		memset (found, 0, MAX (index->n_pages, 1) * sizeof (gboolean));
+
+		if ((i > 0) && (i < (words->len - 1))) {
+			GArray *postings = g_hash_table_lookup (index->terms, word);
+
+			if (postings) {
+				_postings_mark (postings, index->n_pages, found);
+			}
+		} else {
+			GHashTableIter iter;
+			gpointer key = NULL, data = NULL;
+
+			g_hash_table_iter_init (&iter, index->terms);
+
+			while (g_hash_table_iter_next (&iter, &key, &data)) {
+				if (_term_matches ((const gchar*) key, word, i, words->len)) {
+					_postings_mark ((GArray*) data, index->n_pages, found);
+				}
+			}
+		}
+
+		for (gint page = 0; page < index->n_pages; page++) {
+			if (found[page] && (hits[page] == i)) {
+				hits[page]++;
+			}
+		}
+	}
+
+	GArray *ret = g_array_new (FALSE, FALSE, sizeof (gint));
+
+	for (gint page = 0; page < index->n_pages; page++) {
+		if (hits[page] == words->len) {
+			g_array_append_val (ret, page);
+		}
+	}
+
+	g_free (hits);
+	g_free (found);
+	g_ptr_array_unref (words);
+
+	return ret;
+}
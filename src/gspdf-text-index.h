@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2017, Fajar Dwi Darmanto <fajardwidarm@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef GSPDF_TEXT_INDEX_H
+#define GSPDF_TEXT_INDEX_H
+
+#ifndef __G_LIB_H__
+#include <glib.h>
+#endif
+
+G_BEGIN_DECLS
+
+struct _GspdfTextIndex;
+typedef struct _GspdfTextIndex GspdfTextIndex;
+
+GspdfTextIndex *gspdf_text_index_new (gint n_pages);
+
+GspdfTextIndex *gspdf_text_index_new_from_bytes (GBytes *bytes);
+
+void gspdf_text_index_free (GspdfTextIndex *index);
+
+void gspdf_text_index_add_page (
+	GspdfTextIndex *index, gint page, const gchar *text);
+
+gint gspdf_text_index_get_n_pages (const GspdfTextIndex *index);
+
+GBytes *gspdf_text_index_to_bytes (const GspdfTextIndex *index);
+
+GArray *gspdf_text_index_lookup (
+	const GspdfTextIndex *index, const gchar *text);
+
+G_END_DECLS
+
+#endif
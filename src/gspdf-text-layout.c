@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2017, Fajar Dwi Darmanto <fajardwidarm@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include "gspdf-text-layout.h"
+
+#ifndef GSPDF_HIT_INDEX_H
+#include "gspdf-hit-index.h"
+#endif
+
+// the text of a page and the box of each of its characters, in reading
+// order and page units
+struct _GspdfTextLayout {
+	gchar          *text;
+	guint           n_glyphs;
+	GspdfRectangle *rects;
+
+	// n_glyphs + 1 entries, glyph i is text[offsets[i]] to
+	// text[offsets[i + 1]]
+	gsize          *offsets;
+
+	// the glyph nearest to a point, whatever column it is in
+	GspdfHitGrid   *grid;
+};
+
+// takes text and rects, rects has a box for every character of text
+GspdfTextLayout *
+gspdf_text_layout_new (gchar          *text,
+                       GspdfRectangle *rects,
+                       guint           n_rects)
+{
+	g_return_val_if_fail (text != NULL, NULL);
+
+	GspdfTextLayout *ret = g_malloc0 (sizeof (GspdfTextLayout));
+	const glong n_chars = g_utf8_strlen (text, -1);
+
+	ret->text = text;
+	ret->rects = rects;
+	ret->n_glyphs = MIN ((guint) n_chars, n_rects);
+	ret->offsets = g_malloc ((ret->n_glyphs + 1) * sizeof (gsize));
+
+	const gchar *p = text;
+
+	for (guint i = 0; i < ret->n_glyphs; i++) {
+		ret->offsets[i] = p - text;
+		p = g_utf8_next_char (p);
+	}
+
+	ret->offsets[ret->n_glyphs] = p - text;
+
+	gdouble width = 0, height = 0;
+
+	for (guint i = 0; i < ret->n_glyphs; i++) {
+		width = MAX (width, rects[i].x + rects[i].width);
+		height = MAX (height, rects[i].y + rects[i].height);
+	}
+
+	ret->grid = gspdf_hit_grid_new (width, height, rects, ret->n_glyphs);
+
+	return ret;
+}
+
+GspdfTextLayout *
+gspdf_text_layout_new_from_page (GspdfDocumentPage *page)
+{
+	g_return_val_if_fail (page != NULL, NULL);
+
+	GspdfRectangle *rects = NULL;
+	guint n_rects = 0;
+
+	if (!gspdf_document_page_get_text_layout (page, &rects, &n_rects)) {
+		return NULL;
+	}
+
+	gchar *text = gspdf_document_page_get_text (page);
+
+	if (!text) {
+		g_free (rects);
+		return NULL;
+	}
+
+	return gspdf_text_layout_new (text, rects, n_rects);
+}
+
+void
+gspdf_text_layout_free (GspdfTextLayout *layout)
+{
+	g_return_if_fail (layout != NULL);
+
+	g_free (layout->text);
+	g_free (layout->rects);
+	g_free (layout->offsets);
+	gspdf_hit_grid_free (layout->grid);
+	g_free (layout);
+}
+
+const gchar *
+gspdf_text_layout_get_text (const GspdfTextLayout *layout)
+{
+	g_return_val_if_fail (layout != NULL, NULL);
+
+	return layout->text;
+}
+
+// where a selection end at the point falls in reading order: before the
+// glyph nearest to it, or after it when the point is past its middle
+static guint
+_get_glyph_boundary (const GspdfTextLayout *layout,
+                     gdouble                x,
+                     gdouble                y)
+{
+	const gint i = gspdf_hit_grid_get_nearest (layout->grid, x, y);
+
+	if (i < 0) {
+		return 0;
+	}
+
+	const GspdfRectangle *rect = &layout->rects[i];
+
+	return (x > (rect->x + (rect->width / 2))) ? (guint) i + 1 : (guint) i;
+}
+
+// the glyphs between the two ends of selection, like a glyph selection in
+// poppler. Each end goes to the glyph nearest to it, so a drag inside a
+// column stays in it, and a drag up or to the left works the same.
+static gboolean
+_get_selected_glyphs (const GspdfTextLayout *layout,
+                      const GspdfRectangle  *selection,
+                      guint                 *first,
+                      guint                 *last)
+{
+	const guint a = _get_glyph_boundary (layout, selection->x, selection->y);
+	const guint b = _get_glyph_boundary (
+		layout,
+		selection->x + selection->width,
+		selection->y + selection->height
+	);
+
+	if (a == b) {
+		return FALSE;
+	}
+
+	*first = MIN (a, b);
+	*last = MAX (a, b) - 1;
+
+	return TRUE;
+}
+
+static gboolean
+_is_line_break (const GspdfTextLayout *layout,
+                guint                  i)
+{
+	const gchar c = layout->text[layout->offsets[i]];
+
+	return (c == '\n') || (c == '\r');
+}
+
+// a GList of GspdfRectangle, one per run of selected glyphs on a line
+GList *
+gspdf_text_layout_get_selected_region (const GspdfTextLayout *layout,
+                                       const GspdfRectangle  *selection)
+{
+	g_return_val_if_fail (layout != NULL, NULL);
+	g_return_val_if_fail (selection != NULL, NULL);
+
+	guint first = 0, last = 0;
+
+	if (!_get_selected_glyphs (layout, selection, &first, &last)) {
+		return NULL;
+	}
+
+	GList *ret = NULL;
+	GspdfRectangle *line = NULL;
+
+	for (guint i = first; i <= last; i++) {
+		const GspdfRectangle *rect = &layout->rects[i];
+
+		if (_is_line_break (layout, i)) {
+			line = NULL;
+			continue;
+		}
+
+		// glyphs going on to the right at about the same height extend
+		// the current run
+		if (line &&
+		    (rect->x >= line->x) &&
+		    (rect->y < (line->y + line->height)) &&
+		    ((rect->y + rect->height) > line->y))
+		{
+			const gdouble right = MAX (line->x + line->width, rect->x + rect->width);
+			const gdouble bottom = MAX (line->y + line->height, rect->y + rect->height);
+
+			line->y = MIN (line->y, rect->y);
+			line->width = right - line->x;
+			line->height = bottom - line->y;
+			continue;
+		}
+
+		line = g_malloc (sizeof (GspdfRectangle));
+		*line = *rect;
+		ret = g_list_prepend (ret, line);
+	}
+
+	return g_list_reverse (ret);
+}
+
+gchar *
+gspdf_text_layout_get_selected_text (const GspdfTextLayout *layout,
+                                     const GspdfRectangle  *selection)
+{
+	g_return_val_if_fail (layout != NULL, NULL);
+	g_return_val_if_fail (selection != NULL, NULL);
+
+	guint first = 0, last = 0;
+
+	if (!_get_selected_glyphs (layout, selection, &first, &last)) {
+		return NULL;
+	}
+
+	return g_strndup (
+		layout->text + layout->offsets[first],
+		layout->offsets[last + 1] - layout->offsets[first]
+	);
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2017, Fajar Dwi Darmanto <fajardwidarm@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef GSPDF_TEXT_LAYOUT_H
+#define GSPDF_TEXT_LAYOUT_H
+
+#ifndef __G_LIB_H__
+#include <glib.h>
+#endif
+
+#ifndef GSPDF_DOCUMENT_PAGE_H
+#include "gspdf-document/gspdf-document-page.h"
+#endif
+
+G_BEGIN_DECLS
+
+struct _GspdfTextLayout;
+typedef struct _GspdfTextLayout GspdfTextLayout;
+
+GspdfTextLayout *gspdf_text_layout_new (
+	gchar *text, GspdfRectangle *rects, guint n_rects);
+
+GspdfTextLayout *gspdf_text_layout_new_from_page (GspdfDocumentPage *page);
+
+void gspdf_text_layout_free (GspdfTextLayout *layout);
+
+const gchar *gspdf_text_layout_get_text (const GspdfTextLayout *layout);
+
+GList *gspdf_text_layout_get_selected_region (
+	const GspdfTextLayout *layout, const GspdfRectangle *selection);
+
+gchar *gspdf_text_layout_get_selected_text (
+	const GspdfTextLayout *layout, const GspdfRectangle *selection);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2017, Fajar Dwi Darmanto <fajardwidarm@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include "gspdf-buffer-pool.h"
+
+// buffers are handed out in multiples of this, so pages of about the
+// same size share a class
+#define GSPDF_BUFFER_POOL_GRANULE        (64 * 1024)
+#define GSPDF_BUFFER_POOL_DEFAULT_BUDGET (64 * 1024 * 1024)
+
+// stored in front of every buffer, keeps the data 16 bytes aligned
+typedef union {
+	gsize   size;
+	guint8  padding[16];
+} GspdfBufferHeader;
+
+struct _GspdfBufferPool {
+	GMutex      mutex;
+
+	// size class -> GSList of idle buffers
+	GHashTable *classes;
+	gsize       free_bytes;
+	gsize       max_free_bytes;
+};
+
+static void
+_gspdf_buffer_pool_class_free_func (gpointer data)
+{
+	g_slist_free_full ((GSList*) data, g_free);
+}
+
+GspdfBufferPool *
+gspdf_buffer_pool_new (gsize max_free_bytes)
+{
+	GspdfBufferPool *ret = g_malloc0 (sizeof (GspdfBufferPool));
+
+	g_mutex_init (&ret->mutex);
+	ret->classes = g_hash_table_new_full (
+		g_direct_hash,
+		g_direct_equal,
+		NULL,
+		_gspdf_buffer_pool_class_free_func
+	);
+	ret->max_free_bytes = max_free_bytes;
+
+	return ret;
+}
+
+static gpointer
+_gspdf_buffer_pool_default_init (gpointer data)
+{
+	return gspdf_buffer_pool_new (GSPDF_BUFFER_POOL_DEFAULT_BUDGET);
+}
+
+GspdfBufferPool *
+gspdf_buffer_pool_get_default (void)
+{
+	static GOnce once = G_ONCE_INIT;
+
+	g_once (&once, _gspdf_buffer_pool_default_init, NULL);
+
+	return (GspdfBufferPool*) once.retval;
+}
+
+void
+gspdf_buffer_pool_free (GspdfBufferPool *pool)
+{
+	g_return_if_fail (pool != NULL);
+
+	g_hash_table_destroy (pool->classes);
+	g_mutex_clear (&pool->mutex);
+	g_free (pool);
+}
+
+// the returned memory is not cleared, the caller has to initialise it
+gpointer
+gspdf_buffer_pool_acquire (GspdfBufferPool *pool,
+                           gsize            size)
+{
+	g_return_val_if_fail (pool != NULL, NULL);
+	g_return_val_if_fail (size > 0, NULL);
+
+	const gsize class_size = ((size + GSPDF_BUFFER_POOL_GRANULE - 1) /
+	                          GSPDF_BUFFER_POOL_GRANULE) * GSPDF_BUFFER_POOL_GRANULE;
+
+	GspdfBufferHeader *header = NULL;
+
+	g_mutex_lock (&pool->mutex);
+
+	GSList *list = g_hash_table_lookup (pool->classes, GSIZE_TO_POINTER (class_size));
+
+	if (list) {
+		header = (GspdfBufferHeader*) list->data;
+		pool->free_bytes -= class_size;
+
+		g_hash_table_steal (pool->classes, GSIZE_TO_POINTER (class_size));
+		list = g_slist_delete_link (list, list);
+
+		if (list) {
+			g_hash_table_insert (pool->classes, GSIZE_TO_POINTER (class_size), list);
+		}
+	}
+
+	g_mutex_unlock (&pool->mutex);
+
+	if (!header) {
+		header = g_malloc (sizeof (GspdfBufferHeader) + class_size);
+		header->size = class_size;
+	}
+
+	return header + 1;
+}
+
+void
+gspdf_buffer_pool_release (GspdfBufferPool *pool,
+                           gpointer         buffer)
+{
+	g_return_if_fail (pool != NULL);
+
+	if (!buffer) {
+		return;
+	}
+
+	GspdfBufferHeader *header = ((GspdfBufferHeader*) buffer) - 1;
+
+	g_mutex_lock (&pool->mutex);
+
+	if ((pool->free_bytes + header->size) > pool->max_free_bytes) {
+		g_mutex_unlock (&pool->mutex);
+		g_free (header);
+		return;
+	}
+
+	GSList *list = g_hash_table_lookup (pool->classes, GSIZE_TO_POINTER (header->size));
+
+	g_hash_table_steal (pool->classes, GSIZE_TO_POINTER (header->size));
+	g_hash_table_insert (
+		pool->classes,
+		GSIZE_TO_POINTER (header->size),
+		g_slist_prepend (list, header)
+	);
+	pool->free_bytes += header->size;
+
+	g_mutex_unlock (&pool->mutex);
+}
+
+// frees every idle buffer
+void
+gspdf_buffer_pool_trim (GspdfBufferPool *pool)
+{
+	g_return_if_fail (pool != NULL);
+
+	g_mutex_lock (&pool->mutex);
+	g_hash_table_remove_all (pool->classes);
+	pool->free_bytes = 0;
+	g_mutex_unlock (&pool->mutex);
+}
@@ -13,22 +13,30 @@
  *
  */
 
-#ifndef GSPDF_TASK_SCHEDULER_H
-#define GSPDF_TASK_SCHEDULER_H
+#ifndef GSPDF_BUFFER_POOL_H
+#define GSPDF_BUFFER_POOL_H
 
-#ifndef GSPDF_TASK_H
-#include "gspdf-task.h"
+#ifndef __G_LIB_H__
+#include <glib.h>
 #endif
 
-struct _GspdfTaskScheduler;
-typedef struct _GspdfTaskScheduler GspdfTaskScheduler;
+G_BEGIN_DECLS
 
-GspdfTaskScheduler *gspdf_task_scheduler_new (void);
+struct _GspdfBufferPool;
+typedef struct _GspdfBufferPool GspdfBufferPool;
 
-void gspdf_task_scheduler_free (GspdfTaskScheduler *instance);
+GspdfBufferPool *gspdf_buffer_pool_new (gsize max_free_bytes);
 
-void gspdf_task_scheduler_push (GspdfTaskScheduler *instance,
-	                              GspdfTask *task,
-																gboolean urgent);
+GspdfBufferPool *gspdf_buffer_pool_get_default (void);
+
+void gspdf_buffer_pool_free (GspdfBufferPool *pool);
+
+gpointer gspdf_buffer_pool_acquire (GspdfBufferPool *pool, gsize size);
+
+void gspdf_buffer_pool_release (GspdfBufferPool *pool, gpointer buffer);
+
+void gspdf_buffer_pool_trim (GspdfBufferPool *pool);
+
+G_END_DECLS
 
 #endif
@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2017, Fajar Dwi Darmanto <fajardwidarm@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include "gspdf-sidecar.h"
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#define GSPDF_SIDECAR_MAGIC 0x43535347 // "GSSC"
+
+// sidecars kept per kind, the least recently written go first
+#define GSPDF_SIDECAR_MAX_FILES 64
+
+// the fingerprint hashes this much from the start and the end of a file,
+// enough to tell apart two files with the same size and mtime
+#define GSPDF_FILE_ID_CHUNK (64 * 1024)
+
+typedef struct {
+	guint32     magic;
+	// of the payload, every kind keeps its own
+	guint32     version;
+	guint64     payload_size;
+	GspdfFileId id;
+} GspdfSidecarHeader;
+
+typedef struct {
+	gchar  *path;
+	gint64  mtime;
+} GspdfSidecarEntry;
+
+static gboolean
+_file_id_hash_chunk (GInputStream *stream,
+                     goffset       offset,
+                     guchar       *buffer,
+                     GChecksum    *checksum)
+{
+	gsize n_read = 0;
+
+	if (!g_seekable_seek (G_SEEKABLE (stream), offset, G_SEEK_SET, NULL, NULL)) {
+		return FALSE;
+	}
+
+	if (!g_input_stream_read_all (stream, buffer, GSPDF_FILE_ID_CHUNK, &n_read, NULL, NULL)) {
+		return FALSE;
+	}
+
+	g_checksum_update (checksum, buffer, n_read);
+
+	return TRUE;
+}
+
+gboolean
+gspdf_file_id_query (const gchar *uri,
+                     GspdfFileId *id)
+{
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (id != NULL, FALSE);
+
+	GFile *file = g_file_new_for_uri (uri);
+	GFileInfo *info = g_file_query_info (
+		file,
+		G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+		G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+		G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+		G_FILE_QUERY_INFO_NONE,
+		NULL,
+		NULL
+	);
+
+	if (!info) {
+		g_object_unref (file);
+		return FALSE;
+	}
+
+	memset (id, 0, sizeof (GspdfFileId));
+	id->size = (guint64) g_file_info_get_size (info);
+	id->mtime = (gint64) g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+	id->mtime = (id->mtime * G_USEC_PER_SEC) +
+		g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+	g_object_unref (info);
+
+	GFileInputStream *stream = g_file_read (file, NULL, NULL);
+	g_object_unref (file);
+
+	if (!stream) {
+		return FALSE;
+	}
+
+	GChecksum *checksum = g_checksum_new (G_CHECKSUM_SHA1);
+	guchar *buffer = g_malloc (GSPDF_FILE_ID_CHUNK);
+	gboolean ret = _file_id_hash_chunk (G_INPUT_STREAM (stream), 0, buffer, checksum);
+
+	if (ret && (id->size > GSPDF_FILE_ID_CHUNK)) {
+		const goffset tail = MAX (GSPDF_FILE_ID_CHUNK, (goffset) id->size - GSPDF_FILE_ID_CHUNK);
+		ret = _file_id_hash_chunk (G_INPUT_STREAM (stream), tail, buffer, checksum);
+	}
+
+	gsize len = GSPDF_FILE_ID_DIGEST_LEN;
+	g_checksum_get_digest (checksum, id->digest, &len);
+
+	g_checksum_free (checksum);
+	g_free (buffer);
+	g_object_unref (stream);
+
+	return ret;
+}
+
+gboolean
+gspdf_file_id_equal (const GspdfFileId *a,
+                     const GspdfFileId *b)
+{
+	g_return_val_if_fail (a != NULL, FALSE);
+	g_return_val_if_fail (b != NULL, FALSE);
+
+	return (a->size == b->size) &&
+		(a->mtime == b->mtime) &&
+		(memcmp (a->digest, b->digest, GSPDF_FILE_ID_DIGEST_LEN) == 0);
+}
+
+static gchar *
+_sidecar_get_dir (const gchar *kind)
+{
+	return g_build_filename (g_get_user_cache_dir (), "gspdf", kind, NULL);
+}
+
+static gchar *
+_sidecar_get_path (const gchar *kind,
+                   const gchar *uri)
+{
+	gchar *dir = _sidecar_get_dir (kind);
+	gchar *name = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+	gchar *ret = g_build_filename (dir, name, NULL);
+
+	g_free (dir);
+	g_free (name);
+
+	return ret;
+}
+
+static gint
+_sidecar_entry_compare (gconstpointer a,
+                        gconstpointer b)
+{
+	const GspdfSidecarEntry *ea = (const GspdfSidecarEntry*) a;
+	const GspdfSidecarEntry *eb = (const GspdfSidecarEntry*) b;
+
+	return (ea->mtime > eb->mtime) ? -1 : ((ea->mtime < eb->mtime) ? 1 : 0);
+}
+
+static void
+_sidecar_prune (const gchar *kind)
+{
+	gchar *dir_path = _sidecar_get_dir (kind);
+	GDir *dir = g_dir_open (dir_path, 0, NULL);
+
+	if (!dir) {
+		g_free (dir_path);
+		return;
+	}
+
+	GArray *entries = g_array_new (FALSE, FALSE, sizeof (GspdfSidecarEntry));
+	const gchar *name = NULL;
+
+	while ((name = g_dir_read_name (dir)) != NULL) {
+		GspdfSidecarEntry entry;
+		GStatBuf buf;
+
+		entry.path = g_build_filename (dir_path, name, NULL);
+
+		if (g_stat (entry.path, &buf) != 0) {
+			g_free (entry.path);
+			continue;
+		}
+
+		entry.mtime = (gint64) buf.st_mtime;
+		g_array_append_val (entries, entry);
+	}
+
+	g_dir_close (dir);
+	g_free (dir_path);
+
+	g_array_sort (entries, _sidecar_entry_compare);
+
+	for (guint i = 0; i < entries->len; i++) {
+		GspdfSidecarEntry *entry = &g_array_index (entries, GspdfSidecarEntry, i);
+
+		if (i >= GSPDF_SIDECAR_MAX_FILES) {
+			g_remove (entry->path);
+		}
+
+		g_free (entry->path);
+	}
+
+	g_array_unref (entries);
+}
+
+// the payload stored for uri, if the file is still the one it was
+// written for and the payload is of version
+GBytes *
+gspdf_sidecar_load (const gchar       *kind,
+                    guint32            version,
+                    const gchar       *uri,
+                    const GspdfFileId *id)
+{
+	g_return_val_if_fail (kind != NULL, NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+	g_return_val_if_fail (id != NULL, NULL);
+
+	gchar *path = _sidecar_get_path (kind, uri);
+	GMappedFile *mapped = g_mapped_file_new (path, FALSE, NULL);
+	g_free (path);
+
+	if (!mapped) {
+		return NULL;
+	}
+
+	const gsize len = g_mapped_file_get_length (mapped);
+	GspdfSidecarHeader header;
+	GBytes *ret = NULL;
+
+	if (len >= sizeof (GspdfSidecarHeader)) {
+		memcpy (&header, g_mapped_file_get_contents (mapped), sizeof (GspdfSidecarHeader));
+
+		if ((header.magic == GSPDF_SIDECAR_MAGIC) &&
+		    (header.version == version) &&
+		    (header.payload_size == len - sizeof (GspdfSidecarHeader)) &&
+		    gspdf_file_id_equal (&header.id, id)) {
+			GBytes *bytes = g_mapped_file_get_bytes (mapped);
+			ret = g_bytes_new_from_bytes (bytes, sizeof (GspdfSidecarHeader), header.payload_size);
+			g_bytes_unref (bytes);
+		}
+	}
+
+	g_mapped_file_unref (mapped);
+
+	return ret;
+}
+
+gboolean
+gspdf_sidecar_save (const gchar       *kind,
+                    guint32            version,
+                    const gchar       *uri,
+                    const GspdfFileId *id,
+                    gconstpointer      data,
+                    gsize              size)
+{
+	g_return_val_if_fail (kind != NULL, FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (id != NULL, FALSE);
+	g_return_val_if_fail ((data != NULL) || (size == 0), FALSE);
+
+	gchar *dir = _sidecar_get_dir (kind);
+	const gint err = g_mkdir_with_parents (dir, 0700);
+	g_free (dir);
+
+	if (err != 0) {
+		return FALSE;
+	}
+
+	GspdfSidecarHeader header;
+	memset (&header, 0, sizeof (GspdfSidecarHeader));
+	header.magic = GSPDF_SIDECAR_MAGIC;
+	header.version = version;
+	header.payload_size = size;
+	header.id = *id;
+
+	guchar *contents = g_malloc (sizeof (GspdfSidecarHeader) + size);
+	memcpy (contents, &header, sizeof (GspdfSidecarHeader));
+
+	if (size > 0) {
+		memcpy (contents + sizeof (GspdfSidecarHeader), data, size);
+	}
+
+	gchar *path = _sidecar_get_path (kind, uri);
+	const gboolean ret = g_file_set_contents (
+		path,
+		(const gchar*) contents,
+		sizeof (GspdfSidecarHeader) + size,
+		NULL
+	);
+
+	g_free (path);
+	g_free (contents);
+
+	if (ret) {
+		_sidecar_prune (kind);
+	}
+
+	return ret;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2017, Fajar Dwi Darmanto <fajardwidarm@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef GSPDF_SIDECAR_H
+#define GSPDF_SIDECAR_H
+
+#ifndef __G_LIB_H__
+#include <glib.h>
+#endif
+
+G_BEGIN_DECLS
+
+#define GSPDF_FILE_ID_DIGEST_LEN 20
+
+typedef struct {
+	guint64 size;
+	gint64  mtime;
+	guint8  digest[GSPDF_FILE_ID_DIGEST_LEN];
+} GspdfFileId;
+
+gboolean gspdf_file_id_query (const gchar *uri, GspdfFileId *id);
+
+gboolean gspdf_file_id_equal (const GspdfFileId *a, const GspdfFileId *b);
+
+GBytes *gspdf_sidecar_load (const gchar       *kind,
+                            guint32            version,
+                            const gchar       *uri,
+                            const GspdfFileId *id);
+
+gboolean gspdf_sidecar_save (const gchar       *kind,
+                             guint32            version,
+                             const gchar       *uri,
+                             const GspdfFileId *id,
+                             gconstpointer      data,
+                             gsize              size);
+
+G_END_DECLS
+
+#endif
@@ -17,22 +17,34 @@
 
 typedef struct {
 	GMutex              mutex;
+	GMutex              run_mutex;
 	GspdfTaskStatus     status;
 	gboolean            cancel;
+	gint                priority;
 
+	// held while a callback runs, so that resetting one waits for it
+	GMutex              cb_mutex;
 	gspdf_task_callback finished_cb;
 	gpointer            finished_cb_data;
+	gspdf_task_callback progress_cb;
+	gpointer            progress_cb_data;
 } GspdfTaskPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (GspdfTask, gspdf_task, G_TYPE_OBJECT)
 
+#define GSPDF_TASK_SCHEDULER_MAX_WORKERS 32
+
 struct _GspdfTaskScheduler {
- GThread     *thread;
- GAsyncQueue *queue;
+	GThread     **threads;
+	guint         n_threads;
+
+	GMutex        mutex;
+	GCond         cond;
+	GQueue        queue;
+	gboolean      stop;
 };
 
 static gboolean gspdf_task_run (GspdfTask *task);
-static gboolean gspdf_task_get_cancel (GspdfTask *task);
 static void gspdf_task_set_cancel (GspdfTask *task, gboolean cancel);
 static void gspdf_task_set_status (GspdfTask *task, GspdfTaskStatus status);
 
@@ -46,6 +58,12 @@ gspdf_task_dispose (GObject *object)
 static void
 gspdf_task_finalize (GObject *object)
 {
+	GspdfTaskPrivate *priv = gspdf_task_get_instance_private (GSPDF_TASK (object));
+
+	g_mutex_clear (&priv->mutex);
+	g_mutex_clear (&priv->run_mutex);
+	g_mutex_clear (&priv->cb_mutex);
+
 	G_OBJECT_CLASS (gspdf_task_parent_class)->finalize (object);
 }
 
@@ -56,9 +74,12 @@ gspdf_task_init (GspdfTask *task)
 
 	priv->status = GSPDF_TASK_STATUS_IDLE;
 	priv->cancel = FALSE;
+	priv->priority = GSPDF_TASK_PRIORITY_DEFAULT;
 	priv->finished_cb = NULL;
 	priv->finished_cb_data = NULL;
 	g_mutex_init (&priv->mutex);
+	g_mutex_init (&priv->run_mutex);
+	g_mutex_init (&priv->cb_mutex);
 }
 
 static void
@@ -88,9 +109,13 @@ gspdf_task_run (GspdfTask *task)
 	GspdfTaskPrivate *priv = gspdf_task_get_instance_private (task);
 	gboolean ret = FALSE;
 
+	// a task pushed twice must not run on two workers at once
+	g_mutex_lock (&priv->run_mutex);
+
 	if (gspdf_task_get_cancel (task)) {
 		gspdf_task_set_status (task, GSPDF_TASK_STATUS_STOPPED);
 		gspdf_task_set_cancel (task, FALSE);
+		g_mutex_unlock (&priv->run_mutex);
 		return ret;
 	}
 
@@ -100,19 +125,26 @@ gspdf_task_run (GspdfTask *task)
 	if (gspdf_task_get_cancel (task)) {
 		gspdf_task_set_status (task, GSPDF_TASK_STATUS_STOPPED);
 		gspdf_task_set_cancel (task, FALSE);
+		g_mutex_unlock (&priv->run_mutex);
 		return ret;
 	}
 
 	gspdf_task_set_status (task, GSPDF_TASK_STATUS_OK);
 
+	g_mutex_lock (&priv->cb_mutex);
+
 	if (priv->finished_cb) {
 		priv->finished_cb (task, priv->finished_cb_data);
 	}
 
+	g_mutex_unlock (&priv->cb_mutex);
+
+	g_mutex_unlock (&priv->run_mutex);
+
 	return ret;
 }
 
-static gboolean
+gboolean
 gspdf_task_get_cancel (GspdfTask *task)
 {
 	g_return_val_if_fail (GSPDF_IS_TASK (task), FALSE);
@@ -156,6 +188,34 @@ gspdf_task_get_status (GspdfTask *task)
 	return ret;
 }
 
+void
+gspdf_task_set_priority (GspdfTask *task, gint priority)
+{
+	g_return_if_fail (GSPDF_IS_TASK (task));
+
+	GspdfTaskPrivate *priv = gspdf_task_get_instance_private (task);
+
+	g_mutex_lock (&priv->mutex);
+	priv->priority = priority;
+	g_mutex_unlock (&priv->mutex);
+}
+
+gint
+gspdf_task_get_priority (GspdfTask *task)
+{
+	g_return_val_if_fail (GSPDF_IS_TASK (task), GSPDF_TASK_PRIORITY_DEFAULT);
+
+	GspdfTaskPrivate *priv = gspdf_task_get_instance_private (task);
+
+	g_mutex_lock (&priv->mutex);
+	gint ret = priv->priority;
+	g_mutex_unlock (&priv->mutex);
+
+	return ret;
+}
+
+// once this returns, the previous callback is neither running nor
+// called again, so its user_data may go away
 void
 gspdf_task_set_finished_callback (
 	GspdfTask *task, gspdf_task_callback callback, gpointer user_data)
@@ -165,60 +225,251 @@ gspdf_task_set_finished_callback (
 
 	GspdfTaskPrivate *priv = gspdf_task_get_instance_private (task);
 
+	g_mutex_lock (&priv->cb_mutex);
 	priv->finished_cb = callback;
 	priv->finished_cb_data = user_data;
+	g_mutex_unlock (&priv->cb_mutex);
+}
+
+// like the finished callback, called by run implementations through
+// gspdf_task_notify_progress
+void
+gspdf_task_set_progress_callback (
+	GspdfTask *task, gspdf_task_callback callback, gpointer user_data)
+{
+	g_return_if_fail (task != NULL);
+	g_return_if_fail (GSPDF_IS_TASK (task));
+
+	GspdfTaskPrivate *priv = gspdf_task_get_instance_private (task);
+
+	g_mutex_lock (&priv->cb_mutex);
+	priv->progress_cb = callback;
+	priv->progress_cb_data = user_data;
+	g_mutex_unlock (&priv->cb_mutex);
+}
+
+// for run implementations, a cancelled task reports nothing more
+void
+gspdf_task_notify_progress (GspdfTask *task)
+{
+	g_return_if_fail (task != NULL);
+	g_return_if_fail (GSPDF_IS_TASK (task));
+
+	GspdfTaskPrivate *priv = gspdf_task_get_instance_private (task);
+
+	if (gspdf_task_get_cancel (task)) {
+		return;
+	}
+
+	g_mutex_lock (&priv->cb_mutex);
+
+	if (priv->progress_cb) {
+		priv->progress_cb (task, priv->progress_cb_data);
+	}
+
+	g_mutex_unlock (&priv->cb_mutex);
+}
+
+// priorities may change while a task is queued, so the most urgent
+// task is looked up when popping rather than kept sorted on push.
+// Equal priorities keep their push order. Cancelled tasks met on the way
+// are unlinked and handed back in dropped, never run.
+static GspdfTask *
+_gspdf_task_scheduler_pop (GspdfTaskScheduler  *scheduler,
+	                         GSList             **dropped)
+{
+	GList *best = NULL;
+	GList *iter = scheduler->queue.head;
+	GList *next = NULL;
+	gint best_priority = G_MAXINT;
+
+	while (iter) {
+		GspdfTask *task = GSPDF_TASK (iter->data);
+		next = iter->next;
+
+		if (gspdf_task_get_cancel (task)) {
+			gspdf_task_set_status (task, GSPDF_TASK_STATUS_STOPPED);
+			gspdf_task_set_cancel (task, FALSE);
+			g_queue_delete_link (&scheduler->queue, iter);
+			*dropped = g_slist_prepend (*dropped, task);
+		} else {
+			gint priority = gspdf_task_get_priority (task);
+
+			if (!best || priority < best_priority) {
+				best = iter;
+				best_priority = priority;
+			}
+		}
+
+		iter = next;
+	}
+
+	if (!best) {
+		return NULL;
+	}
+
+	GspdfTask *ret = GSPDF_TASK (best->data);
+	g_queue_delete_link (&scheduler->queue, best);
+
+	return ret;
 }
 
 static gpointer
 _gspdf_task_scheduler_func (gpointer data)
 {
-	GAsyncQueue *queue = (GAsyncQueue*) data;
- 	GspdfTask *task = NULL;
+	GspdfTaskScheduler *scheduler = (GspdfTaskScheduler*) data;
+	GspdfTask *task = NULL;
+	GSList *dropped = NULL;
+
+	while (1) {
+		g_mutex_lock (&scheduler->mutex);
+
+		while (!scheduler->stop && g_queue_is_empty (&scheduler->queue)) {
+			g_cond_wait (&scheduler->cond, &scheduler->mutex);
+		}
+
+		if (scheduler->stop) {
+			g_mutex_unlock (&scheduler->mutex);
+			break;
+		}
+
+		task = _gspdf_task_scheduler_pop (scheduler, &dropped);
+
+		g_mutex_unlock (&scheduler->mutex);
+
+		// released outside the lock, disposing a task may be expensive
+		g_slist_free_full (dropped, g_object_unref);
+		dropped = NULL;
+
+		if (!task) {
+			continue;
+		}
+
+		if (gspdf_task_run (task)) {
+			g_mutex_lock (&scheduler->mutex);
+			g_queue_push_tail (&scheduler->queue, task);
+			g_cond_signal (&scheduler->cond);
+			g_mutex_unlock (&scheduler->mutex);
+		} else {
+			g_object_unref (task);
+		}
+	}
+
+	return NULL;
+}
+
+static guint
+_gspdf_task_scheduler_get_default_n_workers (void)
+{
+	const gchar *env = g_getenv ("GSPDF_WORKERS");
 
- 	while (1) {
-	 	task = (GspdfTask*) g_async_queue_pop (queue);
-	 	if (gspdf_task_run (task)) {
-			g_async_queue_push (queue, task);
-	 	} else {
-		 	g_object_unref (task);
-	 	}
- 	}
+	if (env) {
+		guint64 n = g_ascii_strtoull (env, NULL, 10);
 
- 	return NULL;
+		if (n > 0) {
+			return (guint) MIN (n, GSPDF_TASK_SCHEDULER_MAX_WORKERS);
+		}
+	}
+
+	return CLAMP (g_get_num_processors (), 1, GSPDF_TASK_SCHEDULER_MAX_WORKERS);
 }
 
 GspdfTaskScheduler *
 gspdf_task_scheduler_new ()
 {
-	GAsyncQueue *queue = g_async_queue_new ();
-	GThread *thread = g_thread_new (NULL, _gspdf_task_scheduler_func, queue);
-	GspdfTaskScheduler *ret = NULL;
-	ret = g_malloc0 (sizeof (GspdfTaskScheduler));
-	ret->thread = thread;
-	ret->queue = queue;
+	return gspdf_task_scheduler_new_with_workers (0);
+}
 
- 	return ret;
+// n_workers == 0 means one worker per core, or GSPDF_WORKERS if set
+GspdfTaskScheduler *
+gspdf_task_scheduler_new_with_workers (guint n_workers)
+{
+	GspdfTaskScheduler *ret = g_malloc0 (sizeof (GspdfTaskScheduler));
+
+	if (n_workers == 0) {
+		n_workers = _gspdf_task_scheduler_get_default_n_workers ();
+	}
+
+	g_mutex_init (&ret->mutex);
+	g_cond_init (&ret->cond);
+	g_queue_init (&ret->queue);
+	ret->n_threads = MIN (n_workers, GSPDF_TASK_SCHEDULER_MAX_WORKERS);
+	ret->threads = g_malloc0 (sizeof (GThread*) * ret->n_threads);
+
+	for (guint i = 0; i < ret->n_threads; i++) {
+		ret->threads[i] = g_thread_new (
+			"gspdf-worker",
+			_gspdf_task_scheduler_func,
+			ret
+		);
+	}
+
+	return ret;
+}
+
+static gpointer
+_gspdf_task_scheduler_default_init (gpointer data)
+{
+	return gspdf_task_scheduler_new ();
+}
+
+// shared by every page cache of the process, never freed
+GspdfTaskScheduler *
+gspdf_task_scheduler_get_default (void)
+{
+	static GOnce once = G_ONCE_INIT;
+
+	g_once (&once, _gspdf_task_scheduler_default_init, NULL);
+
+	return (GspdfTaskScheduler*) once.retval;
+}
+
+guint
+gspdf_task_scheduler_get_n_workers (GspdfTaskScheduler *instance)
+{
+	g_return_val_if_fail (instance != NULL, 0);
+
+	return instance->n_threads;
 }
 
 void
 gspdf_task_scheduler_free (GspdfTaskScheduler *instance)
 {
 	g_return_if_fail (instance != NULL);
+
+	g_mutex_lock (&instance->mutex);
+	instance->stop = TRUE;
+	g_cond_broadcast (&instance->cond);
+	g_mutex_unlock (&instance->mutex);
+
+	for (guint i = 0; i < instance->n_threads; i++) {
+		g_thread_join (instance->threads[i]);
+	}
+
+	gpointer item = NULL;
+
+	while ((item = g_queue_pop_head (&instance->queue)) != NULL) {
+		g_object_unref (item);
+	}
+
+	g_mutex_clear (&instance->mutex);
+	g_cond_clear (&instance->cond);
+	g_free (instance->threads);
+	g_free (instance);
 }
 
 void
 gspdf_task_scheduler_push (
-	GspdfTaskScheduler *instance, GspdfTask *task, gboolean urgent)
+	GspdfTaskScheduler *instance, GspdfTask *task, gint priority)
 {
 	g_return_if_fail (instance != NULL);
- 	g_return_if_fail (task != NULL);
+	g_return_if_fail (task != NULL);
 	g_return_if_fail (GSPDF_IS_TASK (task));
 
- 	g_object_ref (task);
+	gspdf_task_set_priority (task, priority);
 
- 	if (urgent) {
-		g_async_queue_push_front (instance->queue, task);
-	} else {
-		g_async_queue_push (instance->queue, task);
-	}
+	g_mutex_lock (&instance->mutex);
+	g_queue_push_tail (&instance->queue, g_object_ref (task));
+	g_cond_signal (&instance->cond);
+	g_mutex_unlock (&instance->mutex);
 }
@@ -41,6 +41,11 @@ typedef enum {
 	GSPDF_TASK_STATUS_STOPPED
 } GspdfTaskStatus;
 
+// lower values run first
+#define GSPDF_TASK_PRIORITY_HIGH    -100
+#define GSPDF_TASK_PRIORITY_DEFAULT 0
+#define GSPDF_TASK_PRIORITY_LOW     300
+
 struct _GspdfTaskScheduler;
 typedef struct _GspdfTaskScheduler GspdfTaskScheduler;
 
@@ -48,17 +53,34 @@ typedef void (*gspdf_task_callback) (GspdfTask *task, gpointer user_data);
 
 void gspdf_task_cancel (GspdfTask *task);
 
+gboolean gspdf_task_get_cancel (GspdfTask *task);
+
 GspdfTaskStatus gspdf_task_get_status (GspdfTask *task);
 
+void gspdf_task_set_priority (GspdfTask *task, gint priority);
+
+gint gspdf_task_get_priority (GspdfTask *task);
+
 void gspdf_task_set_finished_callback (
 	GspdfTask *task, gspdf_task_callback callback, gpointer user_data);
 
+void gspdf_task_set_progress_callback (
+	GspdfTask *task, gspdf_task_callback callback, gpointer user_data);
+
+void gspdf_task_notify_progress (GspdfTask *task);
+
 GspdfTaskScheduler *gspdf_task_scheduler_new (void);
 
+GspdfTaskScheduler *gspdf_task_scheduler_get_default (void);
+
+GspdfTaskScheduler *gspdf_task_scheduler_new_with_workers (guint n_workers);
+
+guint gspdf_task_scheduler_get_n_workers (GspdfTaskScheduler *instance);
+
 void gspdf_task_scheduler_free (GspdfTaskScheduler *instance);
 
 void gspdf_task_scheduler_push (
-	GspdfTaskScheduler *instance, GspdfTask *task, gboolean urgent);
+	GspdfTaskScheduler *instance, GspdfTask *task, gint priority);
 
 G_END_DECLS
 
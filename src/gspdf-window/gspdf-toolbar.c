@@ -27,6 +27,7 @@ typedef struct {
 	GtkToolItem *zoomorg_tool_item;
 	GtkToolItem *find_entry_tool_item;
 	GtkToolItem *find_tool_item;
+	GtkToolItem *find_label_tool_item;
 } GspdfToolbarPrivate;
 
 struct _GspdfToolbar {
@@ -47,6 +48,7 @@ enum {
 	PROP_ZOOMORG_TOOL_ITEM,
 	PROP_FIND_ENTRY_TOOL_ITEM,
 	PROP_FIND_TOOL_ITEM,
+	PROP_FIND_LABEL_TOOL_ITEM,
 	N_PROPERTIES
 };
 
@@ -111,6 +113,9 @@ gspdf_toolbar_get_property (GObject    *object,
 		case PROP_FIND_TOOL_ITEM:
 			g_value_set_object (value, priv->find_tool_item);
 			break;
+		case PROP_FIND_LABEL_TOOL_ITEM:
+			g_value_set_object (value, priv->find_label_tool_item);
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
 			break;
@@ -214,6 +219,12 @@ gspdf_toolbar_init (GspdfToolbar *object)
 	);
 
 	gtk_toolbar_insert (GTK_TOOLBAR (object), priv->find_tool_item, -1);
+
+	// find label
+	priv->find_label_tool_item = gtk_tool_item_new ();
+	gtk_container_add (GTK_CONTAINER (priv->find_label_tool_item), gtk_label_new (""));
+
+	gtk_toolbar_insert (GTK_TOOLBAR (object), priv->find_label_tool_item, -1);
 }
 
 /* object's class init */
@@ -313,6 +324,14 @@ gspdf_toolbar_class_init (GspdfToolbarClass *klass)
 		G_PARAM_READABLE
 	);
 
+	obj_properties[PROP_FIND_LABEL_TOOL_ITEM] = g_param_spec_object (
+		"find-label-tool-item",
+		"Find-label-tool-item",
+		"",
+		GTK_TYPE_TOOL_ITEM,
+		G_PARAM_READABLE
+	);
+
 	g_object_class_install_properties (object_class, N_PROPERTIES, obj_properties);
 }
 